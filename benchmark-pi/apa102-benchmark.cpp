@@ -0,0 +1,258 @@
+/*******************************************************************************
+ * benchmark-pi/apa102-benchmark.cpp
+ *
+ * Run PiSPI_APA102 against a fake spidev which records all SPI messages. Checks
+ * the wire format of each frame, counts ioctl() calls per frame, and measures
+ * the cost of setPixel() and show() without any hardware attached. Also compares
+ * the former per pixel color conversion against the bulk APA102Converter, and
+ * the frame rate of synchronous against asynchronous show().
+ *
+ * Copyright (C) 2018 Timo Bingmann <tb@panthema.net>
+ *
+ * All rights reserved. Published under the GNU General Public License v3.0
+ ******************************************************************************/
+
+#include <BlinkenAlgorithms/Strip/PiSPI_APA102.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+using namespace BlinkenAlgorithms;
+
+bool g_terminate = false;
+size_t g_delay_factor = 1000;
+
+/******************************************************************************/
+
+//! busy wait simulating computation of a frame
+static void SpinFor(double ns) {
+    using Clock = std::chrono::steady_clock;
+    Clock::time_point end =
+        Clock::now() + std::chrono::nanoseconds(static_cast<int64_t>(ns));
+    while (Clock::now() < end) { }
+}
+
+//! fake spidev device: records the bytes of each SPI message
+class RecordingSPI
+{
+public:
+    std::vector<std::vector<uint8_t> > messages;
+    bool record = true;
+
+    //! simulated transmission time per byte when not recording
+    double ns_per_byte = 0;
+
+    int message(struct spi_ioc_transfer* xfer, unsigned count) {
+        if (!record) {
+            ++messages_dropped;
+            if (ns_per_byte != 0) {
+                size_t len = 0;
+                for (unsigned i = 0; i < count; ++i)
+                    len += xfer[i].len;
+                // the ioctl() blocks in the kernel while the SPI controller
+                // clocks out the data, so sleep instead of spinning.
+                std::this_thread::sleep_for(std::chrono::nanoseconds(
+                                                static_cast<int64_t>(len * ns_per_byte)));
+            }
+            return 0;
+        }
+        messages.emplace_back();
+        for (unsigned i = 0; i < count; ++i) {
+            const uint8_t* tx = reinterpret_cast<const uint8_t*>(xfer[i].tx_buf);
+            messages.back().insert(messages.back().end(), tx, tx + xfer[i].len);
+        }
+        return 0;
+    }
+
+    size_t messages_dropped = 0;
+};
+
+//! reference conversion of Color to APA102 wire format, formerly done in each
+//! setPixel() call
+static void ExpectedPixel(const Color& c, uint8_t out[4]) {
+    using S = LEDStripBase;
+    unsigned r = S::gamma8(c.r), g = S::gamma8(c.g), b = S::gamma8(c.b);
+    r += S::gamma8(c.w), g += S::gamma8(c.w), b += S::gamma8(c.w);
+    const uint16_t mm = 0x1F;
+    unsigned m = (((std::max(std::max(r, g), b) + 1) * mm - 1) >> 8) + 1;
+    r = (mm * r + (m >> 1)) / m;
+    g = (mm * g + (m >> 1)) / m;
+    b = (mm * b + (m >> 1)) / m;
+    r = r > 255 ? 255 : r, g = g > 255 ? 255 : g;
+    b = b > 255 ? 255 : b, m = m > 31 ? 31 : m;
+    out[0] = 0b11100000 | (0b00011111 & m);
+    out[1] = b, out[2] = g, out[3] = r;
+}
+
+static Color TestColor(size_t i) {
+    return Color::ColorWBGR(static_cast<uint32_t>(i * 2654435761u));
+}
+
+//! check the recorded frame against the expected APA102 wire format
+bool CheckFrame(const PiSPI_APA102& strip, const std::vector<uint8_t>& frame) {
+    size_t n = strip.size();
+    size_t end_bytes = (n / 2 + 7) / 8;
+    if (frame.size() != 4 + 4 * n + end_bytes)
+        return false;
+
+    for (size_t i = 0; i < 4; ++i) {
+        if (frame[i] != 0x00)
+            return false;
+    }
+    for (size_t i = 0; i < n; ++i) {
+        uint8_t px[4];
+        ExpectedPixel(TestColor(i), px);
+        for (size_t k = 0; k < 4; ++k) {
+            if (frame[4 + 4 * i + k] != px[k])
+                return false;
+        }
+    }
+    for (size_t i = 4 + 4 * n; i < frame.size(); ++i) {
+        if (frame[i] != 0xFF)
+            return false;
+    }
+    return true;
+}
+
+void Benchmark(size_t strip_size) {
+    using Clock = std::chrono::steady_clock;
+
+    RecordingSPI spi;
+    PiSPI_APA102 strip(
+        strip_size,
+        [&spi](struct spi_ioc_transfer* xfer, unsigned count) {
+            return spi.message(xfer, count);
+        });
+
+    // check one recorded frame
+    for (size_t i = 0; i < strip_size; ++i)
+        strip.setPixel(i, TestColor(i));
+    strip.show();
+
+    std::vector<uint8_t> frame;
+    for (const std::vector<uint8_t>& m : spi.messages)
+        frame.insert(frame.end(), m.begin(), m.end());
+    bool ok = CheckFrame(strip, frame);
+    size_t messages_per_frame = spi.messages.size();
+
+    // measure setPixel and show without recording
+    spi.record = false;
+    size_t rounds = std::max<size_t>(1, 10000000 / strip_size);
+
+    Clock::time_point ts1 = Clock::now();
+    for (size_t r = 0; r < rounds; ++r) {
+        for (size_t i = 0; i < strip_size; ++i)
+            strip.setPixel(i, TestColor(i + r));
+    }
+    Clock::time_point ts2 = Clock::now();
+    for (size_t r = 0; r < rounds; ++r)
+        strip.show();
+    Clock::time_point ts3 = Clock::now();
+
+    // measure per pixel conversion against bulk conversion
+    std::vector<Color> colors(strip_size);
+    std::vector<APA102Color> wire(strip_size);
+    for (size_t i = 0; i < strip_size; ++i)
+        colors[i] = TestColor(i);
+
+    Clock::time_point ts4 = Clock::now();
+    for (size_t r = 0; r < rounds; ++r) {
+        for (size_t i = 0; i < strip_size; ++i)
+            ExpectedPixel(colors[i], reinterpret_cast<uint8_t*>(&wire[i]));
+    }
+    Clock::time_point ts5 = Clock::now();
+    APA102Converter converter;
+    for (size_t r = 0; r < rounds; ++r)
+        converter.convert(colors.data(), strip_size, wire.data());
+    Clock::time_point ts6 = Clock::now();
+
+    auto ns = [](const Clock::time_point& a, const Clock::time_point& b) {
+                  return std::chrono::duration<double, std::nano>(b - a).count();
+              };
+
+    printf("%8zu %10zu %12zu %12.3f %12.1f %12.3f %12.3f %s\n",
+           strip_size, frame.size(), messages_per_frame,
+           ns(ts1, ts2) / rounds / strip_size, ns(ts2, ts3) / rounds,
+           ns(ts4, ts5) / rounds / strip_size,
+           ns(ts5, ts6) / rounds / strip_size,
+           ok ? "ok" : "FAILED");
+}
+
+/*!
+ * Compare synchronous and asynchronous show(). The fake device sleeps for the
+ * transfer time at 13 MHz, and each frame the caller computes for the same
+ * time, which asynchronous mode can overlap with the transfer.
+ */
+void BenchmarkAsync(size_t strip_size, bool async) {
+    using Clock = std::chrono::steady_clock;
+
+    RecordingSPI spi;
+    PiSPI_APA102 strip(
+        strip_size,
+        [&spi](struct spi_ioc_transfer* xfer, unsigned count) {
+            return spi.message(xfer, count);
+        });
+    strip.set_async(async);
+
+    spi.record = false;
+    spi.ns_per_byte = 8 * 1e9 / 13000000;
+    double wire_ns = strip.frame().size() * spi.ns_per_byte;
+
+    // about one second of simulated transfers
+    size_t frames = std::max<size_t>(10, std::min<size_t>(200, 1e9 / wire_ns));
+    Clock::time_point ts1 = Clock::now();
+    for (size_t f = 0; f < frames; ++f) {
+        for (size_t i = 0; i < strip_size; ++i)
+            strip.setPixel(i, TestColor(i + f));
+        SpinFor(wire_ns);
+        strip.show();
+    }
+    Clock::time_point ts2 = Clock::now();
+
+    // record and check the last frame after the background thread finished
+    strip.set_async(false);
+    spi.record = true;
+    for (size_t i = 0; i < strip_size; ++i)
+        strip.setPixel(i, TestColor(i));
+    strip.show();
+
+    std::vector<uint8_t> frame;
+    for (const std::vector<uint8_t>& m : spi.messages)
+        frame.insert(frame.end(), m.begin(), m.end());
+
+    printf("%8zu %6s %12.1f %12.1f %s\n",
+           strip_size, async ? "async" : "sync", wire_ns / 1000.0,
+           std::chrono::duration<double, std::micro>(ts2 - ts1).count()
+           / frames,
+           CheckFrame(strip, frame) ? "ok" : "FAILED");
+}
+
+int main(int argc, char* argv[]) {
+    std::vector<size_t> sizes;
+    for (int i = 1; i < argc; ++i)
+        sizes.push_back(strtoul(argv[i], nullptr, 10));
+    if (sizes.empty())
+        sizes = { 480, 4800, 100000 };
+
+    printf("%8s %10s %12s %12s %12s %12s %12s\n",
+           "pixels", "bytes", "ioctl/frame", "ns/setPixel", "ns/show",
+           "ns/px single", "ns/px bulk");
+
+    for (size_t strip_size : sizes)
+        Benchmark(strip_size);
+
+    printf("\n%8s %6s %12s %12s\n",
+           "pixels", "mode", "us/transfer", "us/frame");
+
+    for (size_t strip_size : sizes) {
+        BenchmarkAsync(strip_size, /* async */ false);
+        BenchmarkAsync(strip_size, /* async */ true);
+    }
+
+    return 0;
+}
+
+/******************************************************************************/
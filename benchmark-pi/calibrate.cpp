@@ -0,0 +1,92 @@
+/*******************************************************************************
+ * benchmark-pi/calibrate.cpp
+ *
+ * Measure the steps and frame times of all algorithms of
+ * RunRandomAlgorithmAnimation on a MemoryStrip, and write a calibration file
+ * for the Pi programs or a header with a calibration table for embedded builds.
+ *
+ * Copyright (C) 2018 Timo Bingmann <tb@panthema.net>
+ *
+ * All rights reserved. Published under the GNU General Public License v3.0
+ ******************************************************************************/
+
+#include <BlinkenAlgorithms/Animation/Calibration.hpp>
+#include <BlinkenAlgorithms/Animation/RandomAlgorithm.hpp>
+#include <BlinkenAlgorithms/Strip/MemoryStrip.hpp>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+using namespace BlinkenAlgorithms;
+
+bool g_terminate = false;
+size_t g_delay_factor = 1000;
+
+/******************************************************************************/
+
+void Usage(const char* argv0) {
+    fprintf(stderr,
+            "Usage: %s [options] [n]\n"
+            "  -s <us>    frame time of the target strip in microseconds\n"
+            "  -t <sec>   target running time per algorithm (default 30)\n"
+            "  -o <file>  write calibration file\n"
+            "  -H <file>  write header with table s_calibration_table\n",
+            argv0);
+}
+
+int main(int argc, char* argv[]) {
+    size_t n = 300;
+    double target = 30, frame_us = -1;
+    const char* output = nullptr;
+    const char* header = nullptr;
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "-s") == 0 && i + 1 < argc)
+            frame_us = atof(argv[++i]);
+        else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc)
+            target = atof(argv[++i]);
+        else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+            output = argv[++i];
+        else if (strcmp(argv[i], "-H") == 0 && i + 1 < argc)
+            header = argv[++i];
+        else if (argv[i][0] >= '0' && argv[i][0] <= '9')
+            n = strtoul(argv[i], nullptr, 10);
+        else {
+            Usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    // run all algorithms without delays, only measuring steps and frame time
+    g_delay_factor = 0;
+
+    BlinkenSort::Calibration calibration(target);
+    calibration.install();
+
+    MemoryStrip strip(n);
+    for (size_t a = 0; a < random_algorithm_cycle; ++a)
+        RunRandomAlgorithmAnimation(strip);
+
+    if (frame_us >= 0)
+        calibration.set_frame_us(frame_us);
+
+    printf("calibrated %zu algorithms for n = %zu, target %.1f s\n",
+           calibration.size(), n, target);
+
+    if (output && !calibration.save(output)) {
+        fprintf(stderr, "Could not write %s\n", output);
+        return EXIT_FAILURE;
+    }
+    if (header &&
+        !calibration.write_table(header, "s_calibration_table")) {
+        fprintf(stderr, "Could not write %s\n", header);
+        return EXIT_FAILURE;
+    }
+    if (!output && !header)
+        calibration.save("/dev/stdout");
+
+    return 0;
+}
+
+/******************************************************************************/
@@ -0,0 +1,124 @@
+/*******************************************************************************
+ * benchmark-pi/flux-benchmark.cpp
+ *
+ * Measure frame throughput of the Flux.hpp animations on a MemoryStrip. The
+ * delay returned by each animation step is ignored, so the results are the
+ * pure per-frame compute cost.
+ *
+ * Copyright (C) 2018 Timo Bingmann <tb@panthema.net>
+ *
+ * All rights reserved. Published under the GNU General Public License v3.0
+ ******************************************************************************/
+
+#include <BlinkenAlgorithms/Porting/RaspberryPi.hpp>
+
+#include <BlinkenAlgorithms/Animation/Flux.hpp>
+#include <BlinkenAlgorithms/RunAnimation.hpp>
+#include <BlinkenAlgorithms/Strip/MemoryStrip.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+using namespace BlinkenAlgorithms;
+
+bool g_terminate = false;
+size_t g_delay_factor = 1000;
+
+void delay_poll() { }
+
+/******************************************************************************/
+// Count heap allocations
+
+static size_t g_alloc_count = 0;
+
+void* operator new (size_t size) {
+    ++g_alloc_count;
+    void* p = malloc(size);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void operator delete (void* p) noexcept {
+    free(p);
+}
+
+void operator delete (void* p, size_t) noexcept {
+    free(p);
+}
+
+/******************************************************************************/
+
+//! minimum time spent in each animation and strip size
+static const double s_time_budget = 0.5;
+
+template <typename Animation, typename... Args>
+void Benchmark(const char* name, size_t strip_size, Args... args) {
+    using Clock = std::chrono::steady_clock;
+
+    MemoryStrip strip(strip_size);
+
+    size_t alloc_setup = g_alloc_count;
+    Animation ani(strip, args...);
+    alloc_setup = g_alloc_count - alloc_setup;
+
+    size_t alloc_run = g_alloc_count;
+    Clock::time_point ts_start = Clock::now();
+    double elapsed = 0;
+    uint32_t s = 0;
+
+    while (elapsed < s_time_budget) {
+        // run a batch of frames between clock reads
+        for (size_t b = 0; b < 16; ++b) {
+            ani(s++);
+            strip.show();
+        }
+        elapsed = std::chrono::duration<double>(Clock::now() - ts_start).count();
+    }
+
+    alloc_run = g_alloc_count - alloc_run;
+
+    double ns_frame = elapsed * 1e9 / s;
+    printf("%-14s %8zu %9u %14.1f %10.3f %10zu %12.3f\n",
+           name, strip_size, s, ns_frame, ns_frame / strip_size,
+           alloc_setup, static_cast<double>(alloc_run) / s);
+}
+
+void BenchmarkAll(size_t strip_size) {
+    using Strip = MemoryStrip;
+
+    Benchmark<ColorWipeRGBW<Strip> >("ColorWipeRGBW", strip_size);
+    Benchmark<SparkleRGB<Strip> >("SparkleRGB", strip_size);
+    Benchmark<Fire<Strip> >("Fire", strip_size);
+    Benchmark<FireIce<Strip> >("FireIce", strip_size);
+    Benchmark<SprayColor<Strip> >("SprayColor", strip_size);
+    Benchmark<Fireworks<Strip> >("Fireworks", strip_size);
+    Benchmark<KnightSnakes<Strip, /* TrueHSV */ true> >(
+        "KnightSnakes", strip_size, /* speed */ 25000, /* max_snakes */ 40);
+    Benchmark<PulseColor<Strip> >("PulseColor", strip_size);
+    Benchmark<Starlight<Strip> >("Starlight", strip_size);
+    Benchmark<CountPattern<Strip> >("CountPattern", strip_size);
+}
+
+int main(int argc, char* argv[]) {
+    srandom(123456);
+
+    std::vector<size_t> sizes;
+    for (int i = 1; i < argc; ++i)
+        sizes.push_back(strtoul(argv[i], nullptr, 10));
+    if (sizes.empty())
+        sizes = { 300, 4800, 100000 };
+
+    printf("%-14s %8s %9s %14s %10s %10s %12s\n",
+           "animation", "pixels", "frames", "ns/frame", "ns/pixel",
+           "alloc/init", "alloc/frame");
+
+    for (size_t strip_size : sizes)
+        BenchmarkAll(strip_size);
+
+    return 0;
+}
+
+/******************************************************************************/
@@ -0,0 +1,124 @@
+/*******************************************************************************
+ * benchmark-pi/hash-benchmark.cpp
+ *
+ * Run the hash table workload of the hash animations, without animation, for
+ * each hash table and a range of load factors: insert up to the load factor,
+ * look up all inserted and as many absent keys, and delete half of them.
+ * Reports probes, cache lines and comparisons per operation and the
+ * throughput of each phase, and optionally writes all statistics including
+ * the probe length histograms as CSV.
+ *
+ * Copyright (C) 2018 Timo Bingmann <tb@panthema.net>
+ *
+ * All rights reserved. Published under the GNU General Public License v3.0
+ ******************************************************************************/
+
+#include "sort-algorithms.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+using namespace BlinkenAlgorithms;
+
+bool g_terminate = false;
+size_t g_delay_factor = 1000;
+
+/******************************************************************************/
+
+void Usage(const char* argv0) {
+    fprintf(stderr,
+            "Usage: %s [options] [n]\n"
+            "  -a <name>  only run hash tables containing name\n"
+            "  -l <pct>   load factor in percent, may be repeated\n"
+            "             (default 50, 70, 80, 90, 95)\n"
+            "  -o <file>  write statistics and histograms as CSV\n",
+            argv0);
+}
+
+void Benchmark(const Algorithm& algo, size_t n, size_t load, FILE* csv) {
+    g_hash_workload.load_percent = load;
+    PrepareArray(algo, n, 123456 + n);
+    ClearHashStats();
+    algo.func(array.data(), n);
+
+    for (size_t p = 0; p < HASH_PHASES; ++p) {
+        const HashStats& s = g_hash_stats[p];
+        if (s.operations == 0)
+            continue;
+        double ops = s.operations;
+        printf("%-20s %8zu %5zu%% %-6s %6.1f%% %8zu %8.2f %8.2f %8.2f "
+               "%6zu %6zu %10.0f\n",
+               algo.name, n, load, HashPhaseName(HashPhase(p)),
+               100.0 * s.items / n, s.operations,
+               s.probes / ops, s.cache_lines / ops, s.comparisons / ops,
+               s.max_probes, s.max_displacement,
+               s.seconds > 0 ? ops / s.seconds : 0.0);
+    }
+
+    if (csv) {
+        static bool header = true;
+        WriteHashStatsCSV(csv, algo.name, n, header);
+        header = false;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    size_t n = 60000;
+    std::vector<size_t> loads;
+    const char* filter = nullptr;
+    const char* output = nullptr;
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "-a") == 0 && i + 1 < argc)
+            filter = argv[++i];
+        else if (strcmp(argv[i], "-l") == 0 && i + 1 < argc)
+            loads.push_back(strtoul(argv[++i], nullptr, 10));
+        else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+            output = argv[++i];
+        else if (argv[i][0] >= '0' && argv[i][0] <= '9')
+            n = strtoul(argv[i], nullptr, 10);
+        else {
+            Usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (loads.empty())
+        loads = { 50, 70, 80, 90, 95 };
+    if (n >= Item::tombstone) {
+        fprintf(stderr, "n = %zu exceeds Item value range\n", n);
+        return EXIT_FAILURE;
+    }
+
+    FILE* csv = nullptr;
+    if (output && !(csv = fopen(output, "w"))) {
+        fprintf(stderr, "Could not open %s\n", output);
+        return EXIT_FAILURE;
+    }
+
+    // look up all inserted keys and as many absent ones, delete half
+    g_hash_workload.hit_percent = 100;
+    g_hash_workload.miss_percent = 100;
+    g_hash_workload.erase_percent = 50;
+
+    printf("%-20s %8s %6s %-6s %7s %8s %8s %8s %8s %6s %6s %10s\n",
+           "algorithm", "n", "load", "phase", "filled", "ops", "probes",
+           "lines", "cmps", "max", "displ", "ops/s");
+
+    for (const Algorithm& algo : s_algorithms) {
+        if (!algo.is_hash)
+            continue;
+        if (filter && strstr(algo.name, filter) == nullptr)
+            continue;
+        for (size_t load : loads)
+            Benchmark(algo, n, load, csv);
+    }
+
+    if (csv)
+        fclose(csv);
+
+    return 0;
+}
+
+/******************************************************************************/
@@ -0,0 +1,194 @@
+/*******************************************************************************
+ * benchmark-pi/item-benchmark.cpp
+ *
+ * Measure the cost of the BlinkenSort::Item instrumentation policies. The
+ * comparison-based algorithms are instantiated with plain uint16_t, with items
+ * without instrumentation, with inlined counting, and with the default Item,
+ * once without any hook and once with a counting hook behind the virtual
+ * SortAnimationBase. Reports the best of three runs.
+ *
+ * Copyright (C) 2018 Timo Bingmann <tb@panthema.net>
+ *
+ * All rights reserved. Published under the GNU General Public License v3.0
+ ******************************************************************************/
+
+#include <BlinkenAlgorithms/Animation/Sort.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+using namespace BlinkenAlgorithms;
+using namespace BlinkenSort;
+
+bool g_terminate = false;
+size_t g_delay_factor = 1000;
+
+/******************************************************************************/
+
+using NullItem = ItemT<NullInstrumentation>;
+using CountingItem = ItemT<CountingInstrumentation>;
+
+//! counting hook behind the virtual SortAnimationBase
+class CountingHook : public SortAnimationBase
+{
+public:
+    size_t accesses = 0, comparisons = 0;
+
+    void OnAccess(const Item*, bool) override { ++accesses; }
+    void OnComparison(const Item*, const Item*) override { ++comparisons; }
+    void IncrementCounter() override { ++comparisons; }
+};
+
+//! set values without instrumentation
+void SetRaw(uint16_t& a, uint16_t v) { a = v; }
+uint16_t GetRaw(const uint16_t& a) { return a; }
+
+template <typename Instrumentation>
+void SetRaw(ItemT<Instrumentation>& a, uint16_t v) { a.value_ = v; }
+template <typename Instrumentation>
+uint16_t GetRaw(const ItemT<Instrumentation>& a) { return a.value_; }
+
+//! the same sort algorithm instantiated for each item type
+struct Algorithm {
+    const char* name;
+    size_t max_n;
+    void (* raw)(uint16_t* A, size_t n);
+    void (* null)(NullItem* A, size_t n);
+    void (* counting)(CountingItem* A, size_t n);
+    void (* item)(Item* A, size_t n);
+};
+
+#define ALGORITHM(name, max_n) \
+    { #name, max_n, name, name, name, name }
+
+static const size_t quadratic = 10000;
+static const size_t unlimited = size_t(-1);
+
+static const Algorithm s_algorithms[] = {
+    ALGORITHM(SelectionSort, quadratic),
+    ALGORITHM(InsertionSort, quadratic),
+    ALGORITHM(BubbleSort, quadratic),
+    ALGORITHM(QuickSortLR, unlimited),
+    ALGORITHM(QuickSortLL, unlimited),
+    ALGORITHM(QuickSortDualPivot, unlimited),
+    ALGORITHM(BlockQuickSort, unlimited),
+    ALGORITHM(PdqSort, unlimited),
+    ALGORITHM(PdqSortBranchless, unlimited),
+    ALGORITHM(MergeSort, unlimited),
+    ALGORITHM(ShellSort, unlimited),
+    ALGORITHM(HeapSort, unlimited),
+    ALGORITHM(StdSort, unlimited),
+    ALGORITHM(StdStableSort, unlimited),
+    ALGORITHM(WikiSort, unlimited),
+    ALGORITHM(TimSort, unlimited),
+};
+
+//! sort a shuffled permutation, return seconds, or -1 if the result is wrong
+template <typename ItemType>
+double RunOnce(void (*func)(ItemType* A, size_t n), size_t n, unsigned seed) {
+    std::vector<ItemType> A(n);
+    for (size_t i = 0; i < n; ++i)
+        SetRaw(A[i], i);
+    srandom(seed);
+    for (size_t i = 0; i < n; ++i) {
+        uint16_t t = GetRaw(A[i]);
+        size_t j = random(n);
+        SetRaw(A[i], GetRaw(A[j]));
+        SetRaw(A[j], t);
+    }
+    // pivot selection is random, make it the same for all item types
+    srandom(seed);
+
+    using Clock = std::chrono::steady_clock;
+    Clock::time_point ts = Clock::now();
+    func(A.data(), n);
+    double t = std::chrono::duration<double>(Clock::now() - ts).count();
+
+    for (size_t i = 0; i < n; ++i) {
+        if (GetRaw(A[i]) != i)
+            return -1;
+    }
+    return t;
+}
+
+//! best of three runs
+template <typename ItemType>
+double Run(void (*func)(ItemType* A, size_t n), size_t n, unsigned seed) {
+    double best = RunOnce(func, n, seed);
+    for (size_t r = 1; r < 3 && best >= 0; ++r) {
+        double t = RunOnce(func, n, seed);
+        best = t < 0 ? t : std::min(best, t);
+    }
+    return best;
+}
+
+void Benchmark(const Algorithm& algo, size_t n) {
+    unsigned seed = 123456 + n;
+
+    double t_raw = Run(algo.raw, n, seed);
+    double t_null = Run(algo.null, n, seed);
+
+    double t_count = Run(algo.counting, n, seed);
+    CountingInstrumentation::reset();
+    RunOnce(algo.counting, n, seed);
+    size_t comparisons = CountingInstrumentation::comparisons;
+    size_t accesses = CountingInstrumentation::accesses;
+
+    SortAnimationBase::hook = nullptr;
+    double t_item = Run(algo.item, n, seed);
+
+    CountingHook hook;
+    SortAnimationBase::hook = &hook;
+    double t_hook = Run(algo.item, n, seed);
+    hook = CountingHook();
+    RunOnce(algo.item, n, seed);
+    SortAnimationBase::hook = nullptr;
+
+    bool ok = t_raw >= 0 && t_null >= 0 && t_count >= 0 && t_item >= 0 &&
+              t_hook >= 0 && hook.comparisons == comparisons &&
+              hook.accesses == accesses;
+
+    printf("%-20s %8zu %12zu %12zu %9.4f %9.4f %9.4f %9.4f %9.4f %7.2fx %s\n",
+           algo.name, n, comparisons, accesses,
+           t_raw, t_null, t_count, t_item, t_hook,
+           t_raw > 0 ? t_count / t_raw : 0.0, ok ? "ok" : "FAILED");
+}
+
+int main(int argc, char* argv[]) {
+    std::vector<size_t> sizes;
+    const char* filter = nullptr;
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "-a") == 0 && i + 1 < argc)
+            filter = argv[++i];
+        else
+            sizes.push_back(strtoul(argv[i], nullptr, 10));
+    }
+    if (sizes.empty())
+        sizes = { 1000, 10000, 65000 };
+
+    printf("%-20s %8s %12s %12s %9s %9s %9s %9s %9s %8s\n",
+           "algorithm", "n", "comparisons", "accesses",
+           "t_raw", "t_null", "t_count", "t_item", "t_hook", "cnt/raw");
+
+    for (size_t n : sizes) {
+        if (n >= black) {
+            printf("skipping n = %zu: exceeds Item value range\n", n);
+            continue;
+        }
+        for (const Algorithm& algo : s_algorithms) {
+            if (n > algo.max_n)
+                continue;
+            if (filter && strstr(algo.name, filter) == nullptr)
+                continue;
+            Benchmark(algo, n);
+        }
+    }
+
+    return 0;
+}
+
+/******************************************************************************/
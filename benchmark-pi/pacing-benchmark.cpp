@@ -0,0 +1,114 @@
+/*******************************************************************************
+ * benchmark-pi/pacing-benchmark.cpp
+ *
+ * Check how well SortAnimation's adaptive pacing hits its targets. Each
+ * algorithm is animated on a MemoryStrip whose show() takes a fixed time, like
+ * the transmission to a real strip, with a target run time and frame rate.
+ * Reports the achieved run time, frame rate and steps per frame.
+ *
+ * Copyright (C) 2018 Timo Bingmann <tb@panthema.net>
+ *
+ * All rights reserved. Published under the GNU General Public License v3.0
+ ******************************************************************************/
+
+#include <BlinkenAlgorithms/Strip/MemoryStrip.hpp>
+
+#include "sort-algorithms.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+using namespace BlinkenAlgorithms;
+
+bool g_terminate = false;
+size_t g_delay_factor = 1000;
+
+/******************************************************************************/
+
+//! MemoryStrip which sleeps in show() for the transmission time
+class SlowStrip : public MemoryStrip
+{
+public:
+    SlowStrip(size_t strip_size, uint32_t show_micros)
+        : MemoryStrip(strip_size), show_micros_(show_micros) { }
+
+    void show() {
+        MemoryStrip::show();
+        delay_micros(show_micros_);
+    }
+
+private:
+    uint32_t show_micros_;
+};
+
+void Benchmark(const Algorithm& algo, size_t n, uint32_t show_micros,
+               double run_time, double fps) {
+    using Clock = std::chrono::steady_clock;
+    unsigned seed = 123456 + n;
+
+    // count steps on the same input
+    PrepareArray(algo, n, seed);
+    SortStepCounter<Item> counter(array.data(), array.data() + n);
+    SortAnimationBase::hook = &counter;
+    algo.func(array.data(), n);
+    SortAnimationBase::hook = nullptr;
+
+    SlowStrip strip(n, show_micros);
+    SortAnimation<SlowStrip> ani(strip);
+    PrepareArray(algo, n, seed);
+
+    ani.set_pacing(fps, run_time, counter.steps);
+    strip.clear_frames();
+    Clock::time_point ts = Clock::now();
+    algo.func(array.data(), n);
+    double t = std::chrono::duration<double>(Clock::now() - ts).count();
+    size_t frame_steps = ani.pace_frame_steps();
+    size_t frames = strip.frames_shown();
+
+    printf("%-20s %6zu %8u %11zu %8.2f %8.2f %7.1f%% %8zu %8.1f %10zu %s\n",
+           algo.name, n, show_micros, static_cast<size_t>(counter.steps),
+           run_time, t, 100.0 * (t - run_time) / run_time,
+           frames, frames / t, frame_steps,
+           CheckArray(algo, n) ? "ok" : "FAILED");
+}
+
+int main(int argc, char* argv[]) {
+    size_t n = 480;
+    double run_time = 2, fps = 50;
+    const char* filter = nullptr;
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "-a") == 0 && i + 1 < argc)
+            filter = argv[++i];
+        else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc)
+            run_time = atof(argv[++i]);
+        else if (strcmp(argv[i], "-f") == 0 && i + 1 < argc)
+            fps = atof(argv[++i]);
+        else
+            n = strtoul(argv[i], nullptr, 10);
+    }
+
+    printf("%-20s %6s %8s %11s %8s %8s %8s %8s %8s %10s\n",
+           "algorithm", "n", "show_us", "steps", "target", "time",
+           "error", "frames", "fps", "steps/frm");
+
+    static const char* s_selection[] = {
+        "InsertionSort", "QuickSortLR", "MergeSort", "HeapSort",
+        "RadixSortLSD", "CycleSort", "LinearProbingHT"
+    };
+
+    for (uint32_t show_micros : { 0, 2000, 30000 }) {
+        for (const char* name : s_selection) {
+            if (filter && strstr(name, filter) == nullptr)
+                continue;
+            Benchmark(*FindAlgorithm(name), n, show_micros, run_time, fps);
+        }
+    }
+
+    return 0;
+}
+
+/******************************************************************************/
@@ -0,0 +1,170 @@
+/*******************************************************************************
+ * benchmark-pi/parallel-benchmark.cpp
+ *
+ * Measure the multicore scaling of the parallel sorting algorithms. Each
+ * algorithm sorts items without instrumentation on 1, 2, 4, ... threads and
+ * reports the speedup over one thread. Then it is animated on a MemoryStrip
+ * with a ParallelSortAnimation, checking the result and counting the pixels
+ * flashed in each worker's color.
+ *
+ * Copyright (C) 2018 Timo Bingmann <tb@panthema.net>
+ *
+ * All rights reserved. Published under the GNU General Public License v3.0
+ ******************************************************************************/
+
+#include <BlinkenAlgorithms/Animation/ParallelSort.hpp>
+#include <BlinkenAlgorithms/Strip/MemoryStrip.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <set>
+#include <vector>
+
+using namespace BlinkenAlgorithms;
+using namespace BlinkenSort;
+
+bool g_terminate = false;
+size_t g_delay_factor = 1000;
+
+/******************************************************************************/
+
+using NullItem = ItemT<NullInstrumentation>;
+
+struct Algorithm {
+    const char* name;
+    size_t max_n;
+    void (* null)(NullItem* A, size_t n);
+    void (* item)(Item* A, size_t n);
+};
+
+#define ALGORITHM(name, max_n) \
+    { #name, max_n, name, name }
+
+static const size_t quadratic = 10000;
+static const size_t unlimited = size_t(-1);
+
+static const Algorithm s_algorithms[] = {
+    ALGORITHM(ParallelMergeSort, unlimited),
+    ALGORITHM(ParallelQuickSort, unlimited),
+    ALGORITHM(BitonicSort, unlimited),
+    ALGORITHM(OddEvenTranspositionSort, quadratic),
+};
+
+//! MemoryStrip recording which worker colors were shown
+class WorkerStrip : public MemoryStrip
+{
+public:
+    using MemoryStrip::MemoryStrip;
+
+    std::set<uint32_t> colors;
+
+    void show() {
+        for (size_t i = 0; i < size(); ++i)
+            colors.insert(getPixel(i).v);
+        MemoryStrip::show();
+    }
+};
+
+double SortTime(const Algorithm& algo, size_t n, size_t threads,
+                bool& ok) {
+    using Clock = std::chrono::steady_clock;
+    ParallelSortPool().resize(threads);
+
+    std::vector<NullItem> A(n);
+    srandom(123456 + n);
+    for (size_t i = 0; i < n; ++i)
+        A[i].value_ = i;
+    for (size_t i = 0; i < n; ++i)
+        std::swap(A[i].value_, A[random(n)].value_);
+
+    Clock::time_point ts = Clock::now();
+    algo.null(A.data(), n);
+    double t = std::chrono::duration<double>(Clock::now() - ts).count();
+
+    for (size_t i = 0; i < n; ++i)
+        ok = ok && (A[i].value_ == i);
+    return t;
+}
+
+void Benchmark(const Algorithm& algo, size_t n, size_t max_threads,
+               size_t strip_size) {
+    if (n > algo.max_n)
+        n = algo.max_n;
+
+    bool ok = true;
+    double t1 = 0;
+    for (size_t threads = 1; threads <= max_threads; threads *= 2) {
+        // best of three
+        double t = SortTime(algo, n, threads, ok);
+        t = std::min(t, SortTime(algo, n, threads, ok));
+        t = std::min(t, SortTime(algo, n, threads, ok));
+        if (threads == 1)
+            t1 = t;
+
+        printf("%-26s %8zu %7zu %9.4f %7.2fx %s\n",
+               algo.name, n, threads, t, t > 0 ? t1 / t : 0.0,
+               ok ? "ok" : "FAILED");
+    }
+
+    // animate once with a short delay, which lets all workers run even on
+    // fewer cores
+    ParallelSortPool().resize(max_threads);
+    WorkerStrip strip(strip_size);
+    size_t workers_seen = 0;
+    {
+        ParallelSortAnimation<WorkerStrip> ani(
+            strip, ParallelSortPool().threads(), /* delay_time */ 10);
+        ani.array_randomize();
+        algo.item(array.data(), array_size);
+        ani.pflush();
+
+        for (size_t w = 0; w < ParallelSortPool().threads(); ++w)
+            workers_seen += strip.colors.count(ani.worker_color(w).v);
+
+        for (size_t i = 0; i < array_size; ++i)
+            ok = ok && (array[i].value_ == i);
+    }
+    printf("%-26s %8zu %7s %9s %8s %s, %zu frames, %zu of %zu worker "
+           "colors\n", algo.name, strip_size, "anim", "", "",
+           ok ? "ok" : "FAILED", strip.frames_shown(), workers_seen,
+           ParallelSortPool().threads());
+}
+
+int main(int argc, char* argv[]) {
+    size_t n = 60000, strip_size = 480;
+    size_t max_threads = std::max(4u, std::thread::hardware_concurrency());
+    const char* filter = nullptr;
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "-a") == 0 && i + 1 < argc)
+            filter = argv[++i];
+        else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc)
+            max_threads = strtoul(argv[++i], nullptr, 10);
+        else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc)
+            strip_size = strtoul(argv[++i], nullptr, 10);
+        else
+            n = strtoul(argv[i], nullptr, 10);
+    }
+    if (n >= black) {
+        fprintf(stderr, "n = %zu exceeds Item value range\n", n);
+        return EXIT_FAILURE;
+    }
+
+    // bright flashes, such that the worker colors are distinct
+    intensity_flash_high = 255;
+
+    printf("%-26s %8s %7s %9s %8s\n",
+           "algorithm", "n", "threads", "time", "speedup");
+
+    for (const Algorithm& algo : s_algorithms) {
+        if (filter && strstr(algo.name, filter) == nullptr)
+            continue;
+        Benchmark(algo, n, max_threads, strip_size);
+    }
+
+    return 0;
+}
+
+/******************************************************************************/
@@ -0,0 +1,124 @@
+/*******************************************************************************
+ * benchmark-pi/race-benchmark.cpp
+ *
+ * Animate several sorting algorithms side by side on segments of one
+ * MemoryStrip, each on its own thread, and compare with animating them one
+ * after another. Checks that every segment ends sorted and reports the frames
+ * composed by the StripCompositor.
+ *
+ * Copyright (C) 2018 Timo Bingmann <tb@panthema.net>
+ *
+ * All rights reserved. Published under the GNU General Public License v3.0
+ ******************************************************************************/
+
+#include <BlinkenAlgorithms/Strip/MemoryStrip.hpp>
+#include <BlinkenAlgorithms/Strip/SegmentStrip.hpp>
+
+#include "sort-algorithms.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+using namespace BlinkenAlgorithms;
+
+bool g_terminate = false;
+size_t g_delay_factor = 1000;
+
+/******************************************************************************/
+
+//! animate one algorithm on a strip and check the result
+template <typename LEDStrip>
+bool Animate(LEDStrip& strip, const Algorithm& algo, int32_t delay_time) {
+    SortAnimation<LEDStrip> ani(strip, delay_time);
+    ani.array_randomize();
+    algo.func(array.data(), array_size);
+    ani.pflush();
+    return CheckArray(algo, array_size);
+}
+
+void Benchmark(const std::vector<const Algorithm*>& algos, size_t n,
+               int32_t delay_time) {
+    using Clock = std::chrono::steady_clock;
+    size_t count = algos.size();
+
+    // one after another, each on its own strip
+    Clock::time_point ts1 = Clock::now();
+    bool ok_seq = true;
+    size_t frames_seq = 0;
+    for (const Algorithm* algo : algos) {
+        MemoryStrip strip(n);
+        ok_seq = Animate(strip, *algo, delay_time) && ok_seq;
+        frames_seq += strip.frames_shown();
+    }
+    Clock::time_point ts2 = Clock::now();
+
+    // side by side on segments of one strip
+    MemoryStrip strip(count * n);
+    StripCompositor<MemoryStrip> compositor(strip, /* fps */ 1000);
+    compositor.split(count);
+
+    std::vector<char> ok_race(count);
+    using Segment = SegmentStrip<MemoryStrip>;
+    compositor.run(
+        [&](Segment& segment, size_t s) {
+            ok_race[s] = Animate(segment, *algos[s], delay_time);
+        });
+    Clock::time_point ts3 = Clock::now();
+
+    // every pixel of the composed strip must show a sorted item
+    bool ok = ok_seq;
+    for (size_t s = 0; s < count; ++s)
+        ok = ok && ok_race[s];
+    for (size_t i = 0; i < strip.size() && ok; ++i)
+        ok = (strip.getPixel(i).v != 0);
+
+    auto sec = [](const Clock::time_point& a, const Clock::time_point& b) {
+                   return std::chrono::duration<double>(b - a).count();
+               };
+
+    printf("%6zu %6zu %8d %9.3f %9.3f %7.2fx %10zu %10zu %s\n",
+           count, n, delay_time, sec(ts1, ts2), sec(ts2, ts3),
+           sec(ts2, ts3) > 0 ? sec(ts1, ts2) / sec(ts2, ts3) : 0.0,
+           frames_seq, compositor.frames(),
+           ok ? "ok" : "FAILED");
+}
+
+int main(int argc, char* argv[]) {
+    size_t n = 120;
+    int32_t delay_time = 100;
+    std::vector<const Algorithm*> algos;
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+            n = strtoul(argv[++i], nullptr, 10);
+        else if (strcmp(argv[i], "-d") == 0 && i + 1 < argc)
+            delay_time = atoi(argv[++i]);
+        else if (const Algorithm* algo = FindAlgorithm(argv[i]))
+            algos.push_back(algo);
+        else {
+            fprintf(stderr, "Unknown algorithm %s\n", argv[i]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (algos.empty()) {
+        for (const char* name : { "MergeSort", "QuickSortLR", "HeapSort",
+                                  "ShellSort", "RadixSortLSD", "TimSort" })
+            algos.push_back(FindAlgorithm(name));
+    }
+
+    printf("%6s %6s %8s %9s %9s %8s %10s %10s\n",
+           "algos", "n", "delay", "t_seq", "t_race", "speedup",
+           "frames_seq", "frames");
+
+    for (size_t count = 1; count <= algos.size(); count *= 2) {
+        Benchmark(std::vector<const Algorithm*>(
+                      algos.begin(), algos.begin() + count), n, delay_time);
+    }
+
+    return 0;
+}
+
+/******************************************************************************/
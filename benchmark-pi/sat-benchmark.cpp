@@ -0,0 +1,185 @@
+/*******************************************************************************
+ * benchmark-pi/sat-benchmark.cpp
+ *
+ * Measure the flips per second of the Lawa WalkSAT solver without animation on
+ * random 3-SAT formulas with clause/variable ratio 4.2, comparing the classic
+ * mode, which walks occurrence lists to compute scores, with the incremental
+ * mode, which keeps break counts up to date. DIMACS CNF files given with -f
+ * are measured the same way. Small formulas are solved repeatedly from fresh
+ * random assignments until the flip budget is used up.
+ *
+ * With -t the time to solution of the portfolio solver is measured instead,
+ * on 1, 2, 4, ... threads up to the given number, averaged over several seeds.
+ *
+ * Copyright (C) 2018 Timo Bingmann <tb@panthema.net>
+ *
+ * All rights reserved. Published under the GNU General Public License v3.0
+ ******************************************************************************/
+
+#include <BlinkenAlgorithms/Animation/LawaPortfolio.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+using namespace BlinkenAlgorithms;
+using namespace BlinkenLawaSAT;
+
+bool g_terminate = false;
+size_t g_delay_factor = 1000;
+
+/******************************************************************************/
+
+using SatItem = ItemT<NullInstrumentation>;
+
+struct Result {
+    unsigned long flips;
+    size_t solved;
+    size_t unsat;
+    double seconds;
+    bool ok;
+};
+
+//! random formula with vars variables if path is null, else a DIMACS file
+bool Benchmark(const char* path, int vars, unsigned long flips,
+               LawaT<SatItem>& lawa, Result& r) {
+    using Clock = std::chrono::steady_clock;
+
+    srand(123456 + vars);
+    if (!path)
+        lawa.randomFla(vars);
+    else if (!lawa.loadDimacsFile(path))
+        return false;
+    lawa.makeOccurrenceLists();
+
+    r = Result { 0, 0, 0, 0.0, true };
+    if (lawa.num_clauses() == 0)
+        return true;
+    lawa.initializeSearch();
+    while (lawa.num_flips() < flips) {
+        Clock::time_point ts = Clock::now();
+        r.unsat = lawa.search(flips - lawa.num_flips() + 1);
+        r.seconds +=
+            std::chrono::duration<double>(Clock::now() - ts).count();
+
+        r.ok = r.ok && (r.unsat == lawa.countUnsat());
+        if (r.unsat == 0) {
+            // solved: restart from a fresh random assignment
+            ++r.solved;
+            lawa.initializeSearch();
+        }
+    }
+    r.flips = lawa.num_flips();
+    return true;
+}
+
+//! time to solution of the portfolio, each worker flipping at most flips
+void Portfolio(const LawaFormula& formula, const char* path,
+               size_t max_threads, unsigned long flips, size_t runs) {
+    using Clock = std::chrono::steady_clock;
+
+    double t1 = 0;
+    for (size_t threads = 1; threads <= max_threads; threads *= 2) {
+        double seconds = 0;
+        size_t solved = 0;
+        unsigned long total_flips = 0;
+        for (size_t run = 0; run < runs; ++run) {
+            // worker 0 has the same seed for all thread counts
+            LawaPortfolio portfolio(formula, threads, 1000 + run);
+            Clock::time_point ts = Clock::now();
+            portfolio.start(flips);
+            portfolio.join();
+            seconds +=
+                std::chrono::duration<double>(Clock::now() - ts).count();
+            solved += (portfolio.winner() >= 0);
+            total_flips += portfolio.flips();
+        }
+        seconds /= runs;
+        if (threads == 1)
+            t1 = seconds;
+
+        printf("%-12s %8d %8d %7zu %6zu/%-3zu %12lu %9.4f %7.2fx",
+               "portfolio", formula.numVariables, formula.numClauses,
+               threads, solved, runs, total_flips / runs, seconds,
+               seconds > 0 ? t1 / seconds : 0.0);
+        printf(path ? " %s\n" : "\n", path);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    unsigned long flips = 2000000;
+    size_t max_threads = 0, runs = 5;
+    std::vector<int> sizes;
+    std::vector<const char*> files;
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "-r") == 0 && i + 1 < argc)
+            flips = strtoul(argv[++i], nullptr, 10);
+        else if (strcmp(argv[i], "-f") == 0 && i + 1 < argc)
+            files.push_back(argv[++i]);
+        else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc)
+            max_threads = strtoul(argv[++i], nullptr, 10);
+        else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+            runs = std::max(1ul, strtoul(argv[++i], nullptr, 10));
+        else if (argv[i][0] >= '0' && argv[i][0] <= '9')
+            sizes.push_back(atoi(argv[i]));
+        else {
+            fprintf(stderr, "Usage: %s [-r <flips>] [-f <cnf file>] "
+                    "[-t <threads> [-n <runs>]] [variables...]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (sizes.empty() && files.empty())
+        sizes = { 80, 10000, 1000000 };
+    // random formulas first, then files
+    std::vector<const char*> paths(sizes.size(), nullptr);
+    paths.insert(paths.end(), files.begin(), files.end());
+    sizes.resize(paths.size(), 0);
+
+    if (max_threads != 0) {
+        printf("%-12s %8s %8s %7s %10s %12s %9s %8s\n",
+               "mode", "vars", "clauses", "threads", "solved", "flips",
+               "time", "speedup");
+        for (size_t i = 0; i < paths.size(); ++i) {
+            LawaT<SatItem> lawa;
+            srand(123456 + sizes[i]);
+            if (!paths[i])
+                lawa.randomFla(sizes[i]);
+            else if (!lawa.loadDimacsFile(paths[i]))
+                return EXIT_FAILURE;
+            Portfolio(lawa.formula(), paths[i], max_threads, flips, runs);
+        }
+        return 0;
+    }
+
+    printf("%-12s %8s %8s %10s %7s %8s %9s %12s %8s\n",
+           "mode", "vars", "clauses", "flips", "solved", "unsat", "time",
+           "flips/s", "speedup");
+
+    for (size_t i = 0; i < paths.size(); ++i) {
+        double classic_rate = 0;
+        for (LawaMode mode : { LAWA_CLASSIC, LAWA_INCREMENTAL }) {
+            LawaT<SatItem> lawa(mode);
+            Result r;
+            if (!Benchmark(paths[i], sizes[i], flips, lawa, r))
+                return EXIT_FAILURE;
+            double rate = r.seconds > 0 ? r.flips / r.seconds : 0.0;
+            if (mode == LAWA_CLASSIC)
+                classic_rate = rate;
+
+            printf("%-12s %8d %8d %10lu %7zu %8zu %9.4f %12.0f %7.2fx %s",
+                   mode == LAWA_CLASSIC ? "classic" : "incremental",
+                   lawa.num_variables(), lawa.num_clauses(), r.flips,
+                   r.solved, r.unsat, r.seconds, rate,
+                   classic_rate > 0 ? rate / classic_rate : 0.0,
+                   r.ok ? "ok" : "FAILED");
+            printf(paths[i] ? " %s\n" : "\n", paths[i]);
+        }
+    }
+
+    return 0;
+}
+
+/******************************************************************************/
@@ -0,0 +1,118 @@
+/*******************************************************************************
+ * benchmark-pi/sort-algorithms.hpp
+ *
+ * Table of sorting and hashing algorithms shared by the benchmark programs, and
+ * preparation of reproducible inputs.
+ *
+ * Copyright (C) 2018 Timo Bingmann <tb@panthema.net>
+ *
+ * All rights reserved. Published under the GNU General Public License v3.0
+ ******************************************************************************/
+
+#ifndef BENCHMARK_SORT_ALGORITHMS_HEADER
+#define BENCHMARK_SORT_ALGORITHMS_HEADER
+
+#include <BlinkenAlgorithms/Animation/Hashtable.hpp>
+#include <BlinkenAlgorithms/Animation/Sort.hpp>
+
+#include <cstdlib>
+#include <cstring>
+
+using namespace BlinkenSort;
+using namespace BlinkenHashtable;
+
+struct Algorithm {
+    const char* name;
+    SortFunctionType func;
+    //! the same algorithm on 32-bit items, for n beyond the 16-bit Item
+    void (* func32)(Item32* A, size_t n);
+    //! largest n to run, to keep quadratic algorithms in reasonable time
+    size_t max_n;
+    //! hash tables fill an empty array instead of sorting a random one
+    bool is_hash;
+};
+
+static const size_t quadratic = 10000;
+static const size_t unlimited = size_t(-1);
+
+static const Algorithm s_algorithms[] = {
+    { "SelectionSort", SelectionSort, SelectionSort, quadratic, false },
+    { "InsertionSort", InsertionSort, InsertionSort, quadratic, false },
+    { "BubbleSort", BubbleSort, BubbleSort, quadratic, false },
+    { "CocktailShakerSort", CocktailShakerSort, CocktailShakerSort,
+      quadratic, false },
+    { "QuickSortLR", QuickSortLR, QuickSortLR, unlimited, false },
+    { "QuickSortLL", QuickSortLL, QuickSortLL, unlimited, false },
+    { "QuickSortDualPivot", QuickSortDualPivot, QuickSortDualPivot,
+      unlimited, false },
+    { "BlockQuickSort", BlockQuickSort, BlockQuickSort, unlimited, false },
+    { "PdqSort", PdqSort, PdqSort, unlimited, false },
+    { "PdqSortBranchless", PdqSortBranchless, PdqSortBranchless,
+      unlimited, false },
+    { "MergeSort", MergeSort, MergeSort, unlimited, false },
+    { "MergeSortIterative", MergeSortIterative, MergeSortIterative,
+      unlimited, false },
+    { "ShellSort", ShellSort, ShellSort, unlimited, false },
+    { "HeapSort", HeapSort, HeapSort, unlimited, false },
+    { "CycleSort", CycleSort, CycleSort, quadratic, false },
+    { "RadixSortMSD", RadixSortMSD, RadixSortMSD, unlimited, false },
+    { "RadixSortLSD", RadixSortLSD, RadixSortLSD, unlimited, false },
+    { "StdSort", StdSort, StdSort, unlimited, false },
+    { "StdStableSort", StdStableSort, StdStableSort, unlimited, false },
+    { "WikiSort", WikiSort, WikiSort, unlimited, false },
+    { "TimSort", TimSort, TimSort, unlimited, false },
+    { "LinearProbingHT", LinearProbingHT, LinearProbingHT, unlimited, true },
+    { "QuadraticProbingHT", QuadraticProbingHT, QuadraticProbingHT,
+      unlimited, true },
+    { "CuckooHashingTwo", CuckooHashingTwo, CuckooHashingTwo, unlimited, true },
+    { "CuckooHashingThree", CuckooHashingThree, CuckooHashingThree,
+      unlimited, true },
+    { "RobinHoodHT", RobinHoodHT, RobinHoodHT, unlimited, true },
+    { "HopscotchHT", HopscotchHT, HopscotchHT, unlimited, true },
+    { "SwissTableHT", SwissTableHT, SwissTableHT, unlimited, true },
+};
+
+//! fill the array with the same input for each run, bypassing all hooks
+template <typename ItemType = Item>
+void PrepareArray(const Algorithm& algo, size_t n, unsigned seed) {
+    std::vector<ItemType>& A = SortArray<ItemType>();
+    srandom(seed);
+    array_size = n;
+    A.resize(n);
+
+    if (algo.is_hash) {
+        for (size_t i = 0; i < n; ++i)
+            A[i].value_ = ItemType::black;
+        return;
+    }
+
+    for (size_t i = 0; i < n; ++i)
+        A[i].value_ = i;
+    for (size_t i = 0; i < n; ++i)
+        std::swap(A[i].value_, A[random(n)].value_);
+}
+
+template <typename ItemType = Item>
+bool CheckArray(const Algorithm& algo, size_t n) {
+    std::vector<ItemType>& A = SortArray<ItemType>();
+    if (algo.is_hash)
+        return true;
+    for (size_t i = 0; i < n; ++i) {
+        if (A[i].value_ != i)
+            return false;
+    }
+    return true;
+}
+
+//! find algorithm by exact name
+const Algorithm* FindAlgorithm(const char* name) {
+    for (const Algorithm& algo : s_algorithms) {
+        if (strcmp(algo.name, name) == 0)
+            return &algo;
+    }
+    return nullptr;
+}
+
+#endif // !BENCHMARK_SORT_ALGORITHMS_HEADER
+
+/******************************************************************************/
@@ -0,0 +1,130 @@
+/*******************************************************************************
+ * benchmark-pi/sort-benchmark.cpp
+ *
+ * Measure how much of a sorting or hashing animation's running time is spent
+ * in the algorithm itself and how much in the visualization. Each algorithm is
+ * run three times on the same input: without any hook, with a hook that only
+ * counts accesses and comparisons, and with a SortAnimation on a MemoryStrip
+ * with zero delay, whose color palette size is reported. Sizes beyond the
+ * 16-bit Item run on Item32.
+ *
+ * Copyright (C) 2018 Timo Bingmann <tb@panthema.net>
+ *
+ * All rights reserved. Published under the GNU General Public License v3.0
+ ******************************************************************************/
+
+#include <BlinkenAlgorithms/Strip/MemoryStrip.hpp>
+
+#include "sort-algorithms.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+using namespace BlinkenAlgorithms;
+
+bool g_terminate = false;
+size_t g_delay_factor = 1000;
+
+/******************************************************************************/
+
+//! hook which only counts, the baseline cost of the instrumentation
+template <typename ItemType>
+class CountingHook : public SortAnimationBaseT<ItemType>
+{
+public:
+    size_t accesses = 0, comparisons = 0;
+
+    void OnAccess(const ItemType*, bool) override { ++accesses; }
+    void OnComparison(const ItemType*, const ItemType*) override {
+        ++comparisons;
+    }
+    void IncrementCounter() override { ++comparisons; }
+};
+
+template <typename ItemType>
+double RunTimed(void (*func)(ItemType* A, size_t n), size_t n) {
+    using Clock = std::chrono::steady_clock;
+    Clock::time_point ts = Clock::now();
+    func(SortArray<ItemType>().data(), n);
+    return std::chrono::duration<double>(Clock::now() - ts).count();
+}
+
+template <typename ItemType>
+void Benchmark(const Algorithm& algo, void (*func)(ItemType* A, size_t n),
+               size_t n) {
+    using Hook = SortAnimationBaseT<ItemType>;
+    unsigned seed = 123456 + n;
+
+    // run without any hook
+    Hook::hook = nullptr;
+    PrepareArray<ItemType>(algo, n, seed);
+    double time_null = RunTimed(func, n);
+    bool ok = CheckArray<ItemType>(algo, n);
+
+    // run with counting hook
+    CountingHook<ItemType> counter;
+    PrepareArray<ItemType>(algo, n, seed);
+    Hook::hook = &counter;
+    double time_count = RunTimed(func, n);
+    Hook::hook = nullptr;
+
+    // run with full animation, but zero delay and no real strip
+    MemoryStrip strip(n);
+    double time_anim;
+    size_t palette_bytes;
+    {
+        SortAnimation<MemoryStrip, ItemType> ani(strip, /* delay_time */ 0);
+        PrepareArray<ItemType>(algo, n, seed);
+        time_anim = RunTimed(func, n);
+        palette_bytes = ani.palette_bytes();
+    }
+
+    printf("%-20s %8zu %12zu %12zu %10.4f %10.4f %10.4f %6.1f%% %8zu %8zu %s\n",
+           algo.name, n, counter.comparisons, counter.accesses,
+           time_null, time_count, time_anim,
+           time_anim > 0 ? 100.0 * (time_anim - time_null) / time_anim : 0.0,
+           strip.frames_shown(), palette_bytes, ok ? "ok" : "FAILED");
+}
+
+int main(int argc, char* argv[]) {
+    std::vector<size_t> sizes;
+    const char* filter = nullptr;
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "-a") == 0 && i + 1 < argc)
+            filter = argv[++i];
+        else
+            sizes.push_back(strtoul(argv[i], nullptr, 10));
+    }
+    if (sizes.empty())
+        sizes = { 300, 1000, 10000, 65000, 1000000 };
+
+    printf("%-20s %8s %12s %12s %10s %10s %10s %7s %8s %8s\n",
+           "algorithm", "n", "comparisons", "accesses",
+           "t_null", "t_count", "t_anim", "visual", "frames", "palette");
+
+    for (size_t n : sizes) {
+        if (n >= Item32::black) {
+            printf("skipping n = %zu: exceeds Item32 value range\n", n);
+            continue;
+        }
+        for (const Algorithm& algo : s_algorithms) {
+            if (n > algo.max_n)
+                continue;
+            if (filter && strstr(algo.name, filter) == nullptr)
+                continue;
+            // values must stay below the black sentinel
+            if (n < Item::black)
+                Benchmark(algo, algo.func, n);
+            else
+                Benchmark(algo, algo.func32, n);
+        }
+    }
+
+    return 0;
+}
+
+/******************************************************************************/
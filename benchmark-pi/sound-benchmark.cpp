@@ -0,0 +1,335 @@
+/*******************************************************************************
+ * benchmark-pi/sound-benchmark.cpp
+ *
+ * Measure the SortSound hot path without SDL: a sorting thread posts array
+ * accesses via OnSoundAccess() while an audio thread calls SoundCallback() for
+ * buffers of 1024 stereo samples, either paced like the real device or back to
+ * back to maximize contention. Then compare the block SoundMixer against the
+ * former per-sample oscillator loop for a buffer with 64 active oscillators,
+ * and measure oscillator allocation for bursts of notes per callback.
+ *
+ * Copyright (C) 2018 Timo Bingmann <tb@panthema.net>
+ *
+ * All rights reserved. Published under the GNU General Public License v3.0
+ ******************************************************************************/
+
+#include <BlinkenAlgorithms/Animation/SortSound.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+using namespace BlinkenAlgorithms;
+
+bool g_terminate = false;
+size_t g_delay_factor = 1000;
+
+/******************************************************************************/
+// Former mixer: each sample loops over all oscillators
+
+//! Oscillator generating triangle waves
+class ReferenceOscillator
+{
+protected:
+    //! frequency of generated wave
+    float m_freq;
+
+    //! position on array normalized to [0,65536)
+    uint32_t m_relpos;
+
+    //! start and end of wave in sample time
+    size_t m_tstart, m_tend;
+
+    //! duration of oscillation note
+    size_t m_duration;
+
+public:
+    //! construct new oscillator
+    ReferenceOscillator(float freq, size_t relpos, size_t tstart,
+                        size_t duration)
+        : m_freq(freq), m_relpos(relpos),
+          m_tstart(tstart), m_tend(m_tstart + duration),
+          m_duration(duration)
+    { }
+
+    uint32_t relpos() const { return m_relpos; }
+
+    //! triangle wave
+    static int32_t wave(int32_t x) {
+        x &= 0xFFFF;
+
+        if (x <= 65536 / 4)
+            return x;
+        if (x <= 3 * 65536 / 4)
+            return 65536 / 2 - x;
+        return x - 65536;
+    }
+
+    //! envelope applied to wave (uses ADSR)
+    int32_t envelope(size_t i) const {
+        static const uint32_t unit = 65536;
+        uint32_t x = i / m_duration;
+        if (x > unit) x = unit;
+
+        static const uint32_t attack = 0.2 * unit;   // percentage of duration
+        static const uint32_t decay = 0.2 * unit;    // percentage of duration
+        static const uint32_t sustain = 0.8 * unit;  // percentage of amplitude
+        static const uint32_t release = 0.2 * unit;  // percentage of duration
+
+        if (x < attack)
+            return unit / attack * x;
+
+        if (x < attack + decay)
+            return unit - (x - attack) * (unit - sustain) / decay;
+
+        if (x < unit - release)
+            return sustain;
+
+        return sustain / release * (unit - x);
+    }
+
+    int32_t mix_value(size_t p) const {
+        if (p < m_tstart)
+            return 0;
+        if (p >= m_tend)
+            return 0;
+
+        size_t trel = (p - m_tstart);
+
+        return wave(trel * 65536 * m_freq / s_samplerate)
+               * envelope(trel * 65556);
+    }
+
+    //! true if the oscillator is silent at time p
+    bool is_done(size_t p) const {
+        return (p >= m_tend);
+    }
+};
+
+void ReferenceRender(const std::vector<ReferenceOscillator>& osclist,
+                     size_t p, size_t size, int16_t* data) {
+    static int64_t volume_factor = 15000;
+
+    for (size_t i = 0; i < size; ++i) {
+        int64_t vl = 0, vr = 0;
+
+        for (std::vector<ReferenceOscillator>::const_iterator it =
+                 osclist.begin(); it != osclist.end(); ++it)
+        {
+            if (!it->is_done(p)) {
+                int64_t v = it->mix_value(p + i) >> 12;
+                vl += v * (65536 - it->relpos() - 1) / 65536;
+                vr += v * (it->relpos()) / 65536;
+            }
+        }
+
+        vl = (vl * volume_factor) >> 20;
+        vr = (vr * volume_factor) >> 20;
+
+        if (std::max(vl, vr) > 30000) {
+            vl -= 30000, vr -= 30000;
+            vl /= 2, vr /= 2;
+            vl += 30000, vr += 30000;
+            if (std::max(vl, vr) > 31000) {
+                vl -= 31000, vr -= 31000;
+                vl /= 2, vr /= 2;
+                vl += 31000, vr += 31000;
+                if (std::max(vl, vr) > 32000) {
+                    vl = std::min<int64_t>(vl, 32000ll);
+                    vr = std::min<int64_t>(vr, 32000ll);
+                }
+            }
+        }
+        if (std::min(vl, vr) < -30000) {
+            vl += 30000, vr += 30000;
+            vl /= 2, vr /= 2;
+            vl -= 30000, vr -= 30000;
+            if (std::min(vl, vr) < -31000) {
+                vl += 31000, vr += 31000;
+                vl /= 2, vr /= 2;
+                vl -= 31000, vr -= 31000;
+                if (std::min(vl, vr) < -32000) {
+                    vl = std::max<int64_t>(vl, -32000ll);
+                    vr = std::max<int64_t>(vr, -32000ll);
+                }
+            }
+        }
+
+        *data++ = vl, *data++ = vr;
+    }
+}
+
+/******************************************************************************/
+
+//! samples per callback, as opened by blinken-sort-sound-pi
+static const size_t s_samples = 1024;
+
+void Benchmark(const char* name, size_t accesses, bool paced) {
+    using Clock = std::chrono::steady_clock;
+
+    array_max = 1000;
+    SoundReset();
+    size_t dropped_before = SoundAccessDropped();
+
+    std::atomic<bool> done { false };
+    size_t callbacks = 0;
+    double callback_time = 0;
+
+    std::thread audio(
+        [&]() {
+            std::vector<int16_t> buffer(2 * s_samples);
+            while (!done) {
+                Clock::time_point ts = Clock::now();
+                SoundCallback(nullptr, reinterpret_cast<uint8_t*>(buffer.data()),
+                              buffer.size() * sizeof(int16_t));
+                callback_time +=
+                    std::chrono::duration<double>(Clock::now() - ts).count();
+                ++callbacks;
+                if (paced) {
+                    std::this_thread::sleep_until(
+                        ts + std::chrono::microseconds(
+                            1000000 * s_samples / s_samplerate));
+                }
+            }
+        });
+
+    Clock::time_point ts1 = Clock::now();
+    for (size_t i = 0; i < accesses; ++i)
+        OnSoundAccess(i % array_max);
+    Clock::time_point ts2 = Clock::now();
+
+    done = true;
+    audio.join();
+
+    printf("%-8s %10zu %12.2f %10zu %12.1f %10zu\n",
+           name, accesses,
+           std::chrono::duration<double, std::nano>(ts2 - ts1).count() / accesses,
+           callbacks, callbacks ? callback_time * 1e6 / callbacks : 0.0,
+           SoundAccessDropped() - dropped_before);
+}
+
+//! render one buffer with all oscillators active, as after a burst of accesses
+void BenchmarkMixer(size_t oscillators) {
+    using Clock = std::chrono::steady_clock;
+
+    size_t duration = g_sound_sustain * s_samplerate;
+    size_t p = duration / 2;
+
+    std::vector<ReferenceOscillator> osclist;
+    SoundMixer mixer;
+    for (size_t k = 0; k < oscillators; ++k) {
+        uint32_t relpos = (k * 40503u) & 0xFFFF;
+        float freq = arrayindex_to_frequency(relpos / 65536.0f);
+        size_t tstart = k * (p / oscillators);
+        osclist.emplace_back(freq, relpos, tstart, duration);
+        mixer.add(freq, relpos, 0, tstart, duration);
+    }
+
+    std::vector<int16_t> out_ref(2 * s_samples), out_mix(2 * s_samples);
+    std::vector<float> left(s_samples), right(s_samples);
+
+    size_t rounds = 2000;
+    Clock::time_point ts1 = Clock::now();
+    for (size_t r = 0; r < rounds; ++r)
+        ReferenceRender(osclist, p, s_samples, out_ref.data());
+    Clock::time_point ts2 = Clock::now();
+    for (size_t r = 0; r < rounds; ++r) {
+        mixer.render(p, s_samples, left.data(), right.data());
+        SoundMixer::soft_clip(left.data(), right.data(), s_samples,
+                              out_mix.data());
+    }
+    Clock::time_point ts3 = Clock::now();
+
+    // deviation due to the exact envelope and phase
+    int max_diff = 0, max_ref = 0;
+    for (size_t i = 0; i < out_ref.size(); ++i) {
+        max_diff = std::max(max_diff, std::abs(out_ref[i] - out_mix[i]));
+        max_ref = std::max(max_ref, std::abs(int(out_ref[i])));
+    }
+
+    auto us = [&](const Clock::time_point& a, const Clock::time_point& b) {
+                  return std::chrono::duration<double, std::micro>(b - a).count()
+                         / rounds;
+              };
+
+    printf("%12zu %10zu %14.1f %14.1f %8.1fx %10d %10d\n",
+           oscillators, s_samples, us(ts1, ts2), us(ts2, ts3),
+           us(ts1, ts2) / us(ts2, ts3), max_ref, max_diff);
+}
+
+//! add bursts of notes in each callback, as fast sorts do, and render them
+void BenchmarkPool(const char* name, SoundMixer::Policy policy,
+                   size_t max_oscillators, size_t burst) {
+    using Clock = std::chrono::steady_clock;
+
+    SoundMixer mixer(max_oscillators, policy);
+    std::vector<float> left(s_samples), right(s_samples);
+
+    size_t duration = g_sound_sustain * s_samplerate;
+    size_t callbacks = 200, active = 0;
+    double add_time = 0, render_time = 0;
+
+    for (size_t c = 0; c < callbacks; ++c) {
+        size_t p = c * s_samples;
+        float pscale = static_cast<float>(s_samples) / burst;
+
+        Clock::time_point ts1 = Clock::now();
+        for (size_t i = 0; i < burst; ++i) {
+            uint32_t relpos = ((c * burst + i) * 40503u) & 0xFFFF;
+            mixer.add(arrayindex_to_frequency(relpos / 65536.0f), relpos,
+                      p, p + i * pscale, duration);
+        }
+        Clock::time_point ts2 = Clock::now();
+        mixer.render(p, s_samples, left.data(), right.data());
+        Clock::time_point ts3 = Clock::now();
+
+        add_time += std::chrono::duration<double>(ts2 - ts1).count();
+        render_time += std::chrono::duration<double>(ts3 - ts2).count();
+        active += mixer.size();
+    }
+
+    printf("%-12s %6zu %8zu %10.1f %12.1f %8zu %10zu %10zu\n",
+           name, max_oscillators, burst,
+           add_time * 1e9 / (callbacks * burst),
+           render_time * 1e6 / callbacks, active / callbacks,
+           mixer.dropped(), mixer.stolen());
+}
+
+int main(int argc, char* argv[]) {
+    size_t accesses = 10000000;
+    if (argc >= 2)
+        accesses = strtoul(argv[1], nullptr, 10);
+
+    printf("%-8s %10s %12s %10s %12s %10s\n",
+           "audio", "accesses", "ns/access", "callbacks", "us/callback",
+           "dropped");
+
+    Benchmark("paced", accesses, /* paced */ true);
+    Benchmark("busy", accesses, /* paced */ false);
+
+    printf("\n%12s %10s %14s %14s %9s %10s %10s\n",
+           "oscillators", "samples", "us/reference", "us/mixer", "speedup",
+           "peak", "max_diff");
+
+    BenchmarkMixer(16);
+    BenchmarkMixer(s_max_oscillators);
+
+    printf("\n%-12s %6s %8s %10s %12s %8s %10s %10s\n",
+           "policy", "max", "burst", "ns/add", "us/render", "active",
+           "dropped", "stolen");
+
+    for (size_t burst : { 16, 256, 4096 }) {
+        BenchmarkPool("Drop", SoundMixer::Policy::Drop,
+                      s_max_oscillators, burst);
+        BenchmarkPool("StealOldest", SoundMixer::Policy::StealOldest,
+                      s_max_oscillators, burst);
+    }
+    BenchmarkPool("StealOldest", SoundMixer::Policy::StealOldest, 256, 4096);
+
+    return 0;
+}
+
+/******************************************************************************/
@@ -0,0 +1,164 @@
+/*******************************************************************************
+ * benchmark-pi/sound-render.cpp
+ *
+ * Render the sonification of a sorting algorithm offline into a WAV file,
+ * without an audio device. The algorithm runs on a MemoryStrip without any
+ * delay, while a virtual clock advances by one animation step on each delay
+ * hook and timestamps the recorded accesses. The trace is then rendered through
+ * SoundCallback, and the render speed is reported as a multiple of real time.
+ *
+ * Copyright (C) 2018 Timo Bingmann <tb@panthema.net>
+ *
+ * All rights reserved. Published under the GNU General Public License v3.0
+ ******************************************************************************/
+
+#include <BlinkenAlgorithms/Animation/SortSound.hpp>
+#include <BlinkenAlgorithms/Strip/MemoryStrip.hpp>
+
+#include "sort-algorithms.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+using namespace BlinkenAlgorithms;
+
+bool g_terminate = false;
+// positive animation delays are only counted on the virtual clock
+size_t g_delay_factor = 0;
+
+/******************************************************************************/
+
+//! recorded accesses
+static std::vector<SoundEvent> s_trace;
+
+//! virtual time in microseconds, and its advance per animation step
+static size_t s_virtual_us = 0;
+static size_t s_step_us = 0;
+
+void RecordAccess(size_t i) {
+    s_trace.push_back(
+        SoundEvent { s_virtual_us * s_samplerate / 1000000,
+                     static_cast<uint32_t>(i) });
+}
+
+void AdvanceClock() {
+    s_virtual_us += s_step_us;
+}
+
+void Usage(const char* argv0) {
+    fprintf(stderr,
+            "Usage: %s [-a algorithm] [-n size] [-d delay] [-f frame_us] "
+            "[-o output.wav]\n"
+            "  delay as in RunSort(): microseconds per step if positive, or\n"
+            "  number of accesses per frame if negative, in which case each\n"
+            "  frame takes frame_us on the virtual clock.\n", argv0);
+    exit(EXIT_FAILURE);
+}
+
+int main(int argc, char* argv[]) {
+    const char* name = "QuickSortLR";
+    const char* output = "sound-render.wav";
+    size_t n = 480, frame_us = 1000;
+    int32_t delay = -6;
+
+    for (int i = 1; i < argc; ++i) {
+        if (i + 1 >= argc)
+            Usage(argv[0]);
+        else if (strcmp(argv[i], "-a") == 0)
+            name = argv[++i];
+        else if (strcmp(argv[i], "-n") == 0)
+            n = strtoul(argv[++i], nullptr, 10);
+        else if (strcmp(argv[i], "-d") == 0)
+            delay = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-f") == 0)
+            frame_us = strtoul(argv[++i], nullptr, 10);
+        else if (strcmp(argv[i], "-o") == 0)
+            output = argv[++i];
+        else
+            Usage(argv[0]);
+    }
+
+    const Algorithm* algo = FindAlgorithm(name);
+    if (!algo) {
+        fprintf(stderr, "Unknown algorithm %s, choose one of:", name);
+        for (const Algorithm& a : s_algorithms)
+            fprintf(stderr, " %s", a.name);
+        fprintf(stderr, "\n");
+        return EXIT_FAILURE;
+    }
+
+    using Clock = std::chrono::steady_clock;
+    srandom(123456);
+
+    // run algorithm and record accesses on the virtual clock
+    Clock::time_point ts1 = Clock::now();
+    MemoryStrip strip(n);
+    {
+        SortAnimation<MemoryStrip> ani(strip, delay);
+        if (algo->is_hash)
+            ani.array_black();
+        else
+            ani.array_randomize();
+
+        s_step_us = delay > 0 ? delay : frame_us;
+        SoundAccessHook = RecordAccess;
+        DelayHook = AdvanceClock;
+        algo->func(array.data(), n);
+        SoundAccessHook = nullptr;
+        DelayHook = nullptr;
+    }
+    Clock::time_point ts2 = Clock::now();
+
+    // render trace into WAV file
+    WavWriter wav(output, s_samplerate, /* channels */ 2);
+    if (!wav.ok())
+        return EXIT_FAILURE;
+    size_t frames = SoundRenderTrace(s_trace, n, wav);
+    wav.close();
+    Clock::time_point ts3 = Clock::now();
+
+    // an offline render has no deadline, it must keep every access
+    if (SoundAccessDropped() != 0) {
+        fprintf(stderr, "FAILED: %zu accesses dropped rendering %s\n",
+                SoundAccessDropped(), output);
+        return EXIT_FAILURE;
+    }
+
+    // accesses at time 0 must be audible in the first block of 1024 frames
+    if (!s_trace.empty() && s_trace[0].time == 0 && frames != 0) {
+        std::vector<int16_t> first(2 * 1024);
+        FILE* f = fopen(output, "rb");
+        bool silent = true;
+        if (f && fseek(f, 44, SEEK_SET) == 0 &&
+            fread(first.data(), sizeof(int16_t), first.size(), f) ==
+            first.size()) {
+            for (int16_t v : first)
+                silent = silent && (v == 0);
+        }
+        if (f)
+            fclose(f);
+        if (silent) {
+            fprintf(stderr, "FAILED: first block of %s is silent\n", output);
+            return EXIT_FAILURE;
+        }
+    }
+
+    double audio_time = static_cast<double>(frames) / s_samplerate;
+    double render_time = std::chrono::duration<double>(ts3 - ts2).count();
+
+    printf("%s n=%zu delay=%d: %zu accesses, %zu frames shown\n",
+           algo->name, n, delay, s_trace.size(), strip.frames_shown());
+    printf("recorded in %.3f s, rendered %.2f s of audio in %.3f s "
+           "(%.1fx real time), %zu accesses dropped\n",
+           std::chrono::duration<double>(ts2 - ts1).count(),
+           audio_time, render_time, audio_time / render_time,
+           SoundAccessDropped());
+    printf("wrote %s\n", output);
+
+    return 0;
+}
+
+/******************************************************************************/
@@ -0,0 +1,122 @@
+/*******************************************************************************
+ * benchmark-pi/trace-record.cpp
+ *
+ * Record binary access traces of sorting and hashing algorithms at full speed,
+ * report the event counts and trace sizes per algorithm and array size, and
+ * verify each trace by decoding it and replaying its writes onto the initial
+ * array. With -o, traces are saved as <prefix><algorithm>-<n>.bstr.
+ *
+ * Copyright (C) 2018 Timo Bingmann <tb@panthema.net>
+ *
+ * All rights reserved. Published under the GNU General Public License v3.0
+ ******************************************************************************/
+
+#include <BlinkenAlgorithms/Animation/SortTrace.hpp>
+
+#include "sort-algorithms.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace BlinkenAlgorithms;
+
+bool g_terminate = false;
+size_t g_delay_factor = 1000;
+
+/******************************************************************************/
+
+void Record(const Algorithm& algo, size_t n, const char* prefix) {
+    using Clock = std::chrono::steady_clock;
+
+    PrepareArray(algo, n, 123456 + n);
+
+    Clock::time_point ts1 = Clock::now();
+    SortTraceRecorder<> recorder;
+    algo.func(array.data(), n);
+    Clock::time_point ts2 = Clock::now();
+
+    // decode and replay all writes into the array
+    SortTraceReader reader(recorder.data().data(), recorder.data().size());
+    std::vector<uint32_t> values = reader.initial();
+    SortTraceEvent ev;
+    size_t events = 0;
+    while (reader.next(ev)) {
+        ++events;
+        if ((ev.type == SortTraceEvent::Access ||
+             ev.type == SortTraceEvent::AccessNoDelay) &&
+            ev.index[0] != SortTraceEvent::temporary)
+            values[ev.index[0]] = ev.value[0];
+    }
+    Clock::time_point ts3 = Clock::now();
+
+    bool ok = reader.ok() && events == recorder.events();
+    for (size_t i = 0; i < n && ok; ++i)
+        ok = (values[i] == array[i].value_);
+
+    if (prefix) {
+        std::string path =
+            prefix + std::string(algo.name) + "-" + std::to_string(n) + ".bstr";
+        if (!recorder.save(path.c_str()))
+            fprintf(stderr, "Could not write %s\n", path.c_str());
+    }
+
+    size_t bytes = recorder.data().size();
+    printf("%-20s %8zu %11zu %10zu %10zu %10zu %8zu %11zu %6.2f %8.4f %8.4f %s\n",
+           algo.name, n, recorder.events(),
+           recorder.count(SortTraceEvent::Access),
+           recorder.count(SortTraceEvent::AccessNoDelay),
+           recorder.count(SortTraceEvent::Comparison),
+           recorder.count(SortTraceEvent::Counter),
+           bytes, static_cast<double>(bytes) / std::max<size_t>(1, events),
+           std::chrono::duration<double>(ts2 - ts1).count(),
+           std::chrono::duration<double>(ts3 - ts2).count(),
+           ok ? "ok" : "FAILED");
+}
+
+int main(int argc, char* argv[]) {
+    std::vector<size_t> sizes;
+    const char* filter = nullptr;
+    const char* prefix = nullptr;
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "-a") == 0 && i + 1 < argc)
+            filter = argv[++i];
+        else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+            prefix = argv[++i];
+        else
+            sizes.push_back(strtoul(argv[i], nullptr, 10));
+    }
+    if (sizes.empty())
+        sizes = { 300, 1000, 10000 };
+
+    // trace the lookups and deletions of the hash tables too
+    g_hash_workload.hit_percent = 50;
+    g_hash_workload.miss_percent = 50;
+    g_hash_workload.erase_percent = 50;
+
+    printf("%-20s %8s %11s %10s %10s %10s %8s %11s %6s %8s %8s\n",
+           "algorithm", "n", "events", "access", "nodelay", "compare",
+           "counter", "bytes", "B/ev", "t_rec", "t_dec");
+
+    for (size_t n : sizes) {
+        if (n >= black) {
+            printf("skipping n = %zu: exceeds Item value range\n", n);
+            continue;
+        }
+        for (const Algorithm& algo : s_algorithms) {
+            if (n > algo.max_n)
+                continue;
+            if (filter && strstr(algo.name, filter) == nullptr)
+                continue;
+            Record(algo, n, prefix);
+        }
+    }
+
+    return 0;
+}
+
+/******************************************************************************/
@@ -0,0 +1,134 @@
+/*******************************************************************************
+ * benchmark-pi/trace-replay.cpp
+ *
+ * Compare a live SortAnimation with replaying its recorded trace. Each
+ * algorithm is recorded into a trace file, then run live on a MemoryStrip and
+ * replayed from the memory-mapped file on a second MemoryStrip, both with zero
+ * delay. Reports both running times, checks that both strips showed the same
+ * number of frames and end with the same pixels, and measures random seeks.
+ *
+ * Copyright (C) 2018 Timo Bingmann <tb@panthema.net>
+ *
+ * All rights reserved. Published under the GNU General Public License v3.0
+ ******************************************************************************/
+
+#include <BlinkenAlgorithms/Animation/SortReplay.hpp>
+#include <BlinkenAlgorithms/Strip/MemoryStrip.hpp>
+
+#include "sort-algorithms.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+using namespace BlinkenAlgorithms;
+
+bool g_terminate = false;
+size_t g_delay_factor = 1000;
+
+/******************************************************************************/
+
+void Benchmark(const Algorithm& algo, size_t n, const char* path) {
+    using Clock = std::chrono::steady_clock;
+    unsigned seed = 123456 + n;
+
+    {
+        PrepareArray(algo, n, seed);
+        SortTraceRecorder<> recorder;
+        algo.func(array.data(), n);
+        if (!recorder.save(path)) {
+            fprintf(stderr, "Could not write %s\n", path);
+            return;
+        }
+    }
+
+    // run live animation
+    MemoryStrip live_strip(n);
+    Clock::time_point ts1 = Clock::now();
+    {
+        SortAnimation<MemoryStrip> ani(live_strip, /* delay_time */ 0);
+        live_strip.clear_frames();
+        PrepareArray(algo, n, seed);
+        // show the initial array like array_randomize() does
+        for (size_t i = 0; i < n; ++i)
+            ani.flash_low(i);
+        algo.func(array.data(), n);
+    }
+    Clock::time_point ts2 = Clock::now();
+
+    // replay the trace file
+    MappedFile file(path);
+    MemoryStrip replay_strip(n);
+    Clock::time_point ts3 = Clock::now();
+    SortReplay<MemoryStrip> replay(replay_strip, file, /* delay_time */ 0);
+    Clock::time_point ts4 = Clock::now();
+    replay_strip.clear_frames();
+    replay.play();
+    Clock::time_point ts5 = Clock::now();
+
+    bool ok = replay.ok() && replay.event() == replay.events() &&
+              live_strip.frames_shown() == replay_strip.frames_shown();
+    for (size_t i = 0; i < n && ok; ++i)
+        ok = (live_strip.getPixel(i).v == replay_strip.getPixel(i).v);
+
+    // random seeks
+    size_t seeks = 100;
+    srandom(seed);
+    Clock::time_point ts6 = Clock::now();
+    for (size_t s = 0; s < seeks; ++s)
+        replay.seek(random(replay.events() + 1));
+    Clock::time_point ts7 = Clock::now();
+
+    auto sec = [](const Clock::time_point& a, const Clock::time_point& b) {
+                   return std::chrono::duration<double>(b - a).count();
+               };
+
+    printf("%-20s %8zu %11zu %9zu %8zu %9.4f %9.4f %9.4f %7.1fx %9.1f %s\n",
+           algo.name, n, static_cast<size_t>(replay.events()),
+           replay.keyframes(), replay.keyframe_interval(),
+           sec(ts1, ts2), sec(ts3, ts4), sec(ts4, ts5),
+           sec(ts4, ts5) > 0 ? sec(ts1, ts2) / sec(ts4, ts5) : 0.0,
+           sec(ts6, ts7) * 1e6 / seeks, ok ? "ok" : "FAILED");
+}
+
+int main(int argc, char* argv[]) {
+    std::vector<size_t> sizes;
+    const char* filter = nullptr;
+    const char* path = "/tmp/trace-replay.bstr";
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "-a") == 0 && i + 1 < argc)
+            filter = argv[++i];
+        else if (strcmp(argv[i], "-f") == 0 && i + 1 < argc)
+            path = argv[++i];
+        else
+            sizes.push_back(strtoul(argv[i], nullptr, 10));
+    }
+    if (sizes.empty())
+        sizes = { 300, 1000, 10000 };
+
+    printf("%-20s %8s %11s %9s %8s %9s %9s %9s %8s %9s\n",
+           "algorithm", "n", "events", "keyframes", "interval",
+           "t_live", "t_index", "t_replay", "speedup", "us/seek");
+
+    for (size_t n : sizes) {
+        if (n >= black) {
+            printf("skipping n = %zu: exceeds Item value range\n", n);
+            continue;
+        }
+        for (const Algorithm& algo : s_algorithms) {
+            if (n > algo.max_n)
+                continue;
+            if (filter && strstr(algo.name, filter) == nullptr)
+                continue;
+            Benchmark(algo, n, path);
+        }
+    }
+
+    remove(path);
+    return 0;
+}
+
+/******************************************************************************/
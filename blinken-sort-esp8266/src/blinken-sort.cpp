@@ -8,11 +8,15 @@
 
 #include <Arduino.h>
 
+#include <BlinkenAlgorithms/Animation/Calibration.hpp>
 #include <BlinkenAlgorithms/Animation/RandomAlgorithm.hpp>
 #include <BlinkenAlgorithms/Strip/NeoPixelBusAdapter.hpp>
 
 #include <LiquidCrystal_I2C.h>
 
+// generated on the Pi with: calibrate -s 12000 -H calibration-table.hpp 300
+#include "calibration-table.hpp"
+
 // four element pixels, RGBW SK6812 strip
 NeoPixelBus<NeoRgbwFeature, NeoEsp8266Dma800KbpsMethod> strip(/* strip_size */ 300);
 
@@ -53,6 +57,12 @@ NeoPixelBus<NeoRgbwFeature, NeoEsp8266Dma800KbpsMethod> strip(/* strip_size */ 3
 bool g_terminate = false;
 size_t g_delay_factor = 1000;
 
+// delay times for about 30 seconds per algorithm, refined after each run
+BlinkenSort::Calibration calibration(
+    s_calibration_table,
+    sizeof(s_calibration_table) / sizeof(s_calibration_table[0]),
+    /* target */ 30);
+
 // set the LCD address to 0x27 for a 16 chars and 2 line display
 LiquidCrystal_I2C lcd(0x27, 16, 2);
 
@@ -91,6 +101,8 @@ void setup() {
     BlinkenSort::AlgorithmNameHook = OnAlgorithmName;
 
     BlinkenSort::intensity_flash_high = 255;
+
+    calibration.install();
 }
 
 using namespace BlinkenAlgorithms;
@@ -0,0 +1,27 @@
+// generated by BlinkenSort::Calibration::write_table()
+static constexpr BlinkenSort::CalibrationEntry s_calibration_table[] = {
+    { "MergeSort", 300, 4587, 12000.0f },
+    { "Insertion Sort", 300, 62692, 12000.0f },
+    { "QuickSort (LR)\nHoare", 300, 5215, 12000.0f },
+    { "QuickSort (LL)\nLomoto", 300, 5709, 12000.0f },
+    { "QuickSort\nDual Pivot", 300, 4484, 12000.0f },
+    { "ShellSort", 300, 6233, 12000.0f },
+    { "HeapSort", 300, 8440, 12000.0f },
+    { "CycleSort", 300, 876, 12000.0f },
+    { "RadixSort-MSD\n(High First)", 300, 6202, 12000.0f },
+    { "RadixSort-LSD\n(Low First)", 300, 1500, 12000.0f },
+    { "std::sort", 300, 4777, 12000.0f },
+    { "std::stable_sort", 300, 3819, 12000.0f },
+    { "WikiSort", 300, 10542, 12000.0f },
+    { "TimSort", 300, 4932, 12000.0f },
+    { "Selection Sort", 300, 45448, 12000.0f },
+    { "Bubble Sort", 300, 91038, 12000.0f },
+    { "Cocktail-Shaker Sort", 300, 69965, 12000.0f },
+    { "Linear Probe\nHash Table", 300, 1451, 12000.0f },
+    { "Quadratic Probe Hash Table", 300, 1109, 12000.0f },
+    { "Cuckoo Two\nHash Table", 300, 572, 12000.0f },
+    { "Cuckoo Three\nHash Table", 300, 1750, 12000.0f },
+    { "Robin Hood\nHash Table", 300, 1518, 12000.0f },
+    { "Hopscotch\nHash Table", 300, 1484, 12000.0f },
+    { "Swiss Table\nHash Table", 300, 270, 12000.0f },
+};
@@ -6,7 +6,12 @@
  * All rights reserved. Published under the GNU General Public License v3.0
  ******************************************************************************/
 
+#include <BlinkenAlgorithms/Animation/Calibration.hpp>
+#include <BlinkenAlgorithms/Animation/LawaPortfolio.hpp>
+#include <BlinkenAlgorithms/Animation/ParallelSort.hpp>
 #include <BlinkenAlgorithms/Animation/RandomAlgorithm.hpp>
+#include <BlinkenAlgorithms/Animation/SortRace.hpp>
+#include <BlinkenAlgorithms/Animation/SortReplay.hpp>
 #include <BlinkenAlgorithms/Strip/PiSPI_APA102.hpp>
 
 using namespace BlinkenAlgorithms;
@@ -16,9 +21,161 @@ PiSPI_APA102 my_strip("/dev/spidev0.0", /* strip_size */ 5 * 96);
 bool g_terminate = false;
 size_t g_delay_factor = 1000;
 
-int main() {
+//! play traces recorded by benchmark-pi/trace-record for about 30 seconds each
+int ReplayTraces(int argc, char* argv[]) {
+    while (1) {
+        for (int i = 1; i < argc; ++i) {
+            MappedFile file(argv[i]);
+            BlinkenSort::SortReplay<PiSPI_APA102> replay(my_strip, file);
+            if (!replay.ok()) {
+                fprintf(stderr, "Could not replay %s\n", argv[i]);
+                return -1;
+            }
+            replay.set_duration(30);
+            replay.play();
+            replay.yield_delay(2000000);
+        }
+    }
+}
+
+//! race four random algorithms side by side, each on a quarter of the strip
+int RaceAlgorithms() {
+    using namespace BlinkenSort;
+    static const SortRaceEntry<> s_race[] = {
+        { "MergeSort", MergeSort },
+        { "QuickSort (LR)", QuickSortLR },
+        { "QuickSort (LL)", QuickSortLL },
+        { "QuickSort Dual Pivot", QuickSortDualPivot },
+        { "Block QuickSort", BlockQuickSort },
+        { "pdqsort", PdqSortBranchless },
+        { "ShellSort", ShellSort },
+        { "HeapSort", HeapSort },
+        { "RadixSort-MSD", RadixSortMSD },
+        { "RadixSort-LSD", RadixSortLSD },
+        { "std::sort", StdSort },
+        { "std::stable_sort", StdStableSort },
+        { "WikiSort", WikiSort },
+        { "TimSort", TimSort },
+    };
+    static const size_t s_race_size = sizeof(s_race) / sizeof(s_race[0]);
+
+    SortRaceEntry<> algos[4];
+    while (!g_terminate) {
+        // draw four distinct algorithms
+        for (size_t a = 0; a < 4; ++a) {
+            size_t r;
+            do {
+                r = random(s_race_size);
+            } while (std::any_of(
+                         algos, algos + a, [r](const SortRaceEntry<>& e) {
+                             return e.sort_function == s_race[r].sort_function;
+                         }));
+            algos[a] = s_race[r];
+        }
+        RunSortRace(my_strip, algos, 4, /* delay_time */ 20000);
+    }
+    return 0;
+}
+
+//! show the parallel algorithms on all cores, with one color per worker
+int ParallelAlgorithms() {
+    using namespace BlinkenSort;
+    size_t threads = std::thread::hardware_concurrency();
+    intensity_flash_high = 255;
+
+    while (!g_terminate) {
+        RunParallelSort(my_strip, "Parallel MergeSort",
+                        ParallelMergeSort, threads, 20000);
+        RunParallelSort(my_strip, "Parallel QuickSort",
+                        ParallelQuickSort, threads, 20000);
+        RunParallelSort(my_strip, "Bitonic Sort",
+                        BitonicSort, threads, 10000);
+        RunParallelSort(my_strip, "Odd-Even Transposition Sort",
+                        OddEvenTranspositionSort, threads, 1000);
+    }
+    return 0;
+}
+
+//! solve DIMACS CNF files with the SAT animation, projecting large formulas
+int SolveFormulas(int argc, char* argv[]) {
+    using namespace BlinkenLawaSAT;
+    while (!g_terminate) {
+        for (int i = 2; i < argc && !g_terminate; ++i) {
+            Lawa lawa;
+            if (!lawa.loadDimacsFile(argv[i]))
+                return -1;
+            size_t unsat = RunLawaSAT(my_strip, lawa, /* max_rounds */ -1);
+            printf("%s: %d variables, %d clauses, %lu flips, %zu unsat\n",
+                   argv[i], lawa.num_variables(), lawa.num_clauses(),
+                   lawa.num_flips(), unsat);
+            delay_millis(2000);
+        }
+    }
+    return 0;
+}
+
+//! solve DIMACS CNF files with a portfolio of searches on all cores
+int SolveFormulasPortfolio(int argc, char* argv[]) {
+    using namespace BlinkenLawaSAT;
+    size_t threads = std::thread::hardware_concurrency();
+    while (!g_terminate) {
+        for (int i = 2; i < argc && !g_terminate; ++i) {
+            Lawa lawa;
+            if (!lawa.loadDimacsFile(argv[i]))
+                return -1;
+            size_t unsat = RunLawaPortfolio(my_strip, lawa.formula(), threads);
+            printf("%s: %d variables, %d clauses, %zu unsat\n",
+                   argv[i], lawa.num_variables(), lawa.num_clauses(), unsat);
+            delay_millis(2000);
+        }
+    }
+    return 0;
+}
+
+//! CSV file for hash statistics, set by --hash-stats <file>
+static const char* s_hash_stats_path = nullptr;
+
+//! append the workload statistics of each hash animation to a CSV file
+void AppendHashStats(const char* name, size_t n) {
+    FILE* f = fopen(s_hash_stats_path, "a");
+    if (!f)
+        return;
+    BlinkenHashtable::WriteHashStatsCSV(f, name, n, ftell(f) == 0);
+    fclose(f);
+}
+
+int main(int argc, char* argv[]) {
     srandom(time(nullptr));
 
+    // transmit frames in the background while the next one is computed
+    my_strip.set_async(true);
+
+    // the animation loop writes no files unless asked to collect statistics
+    if (argc >= 3 && strcmp(argv[1], "--hash-stats") == 0) {
+        s_hash_stats_path = argv[2];
+        // drop the option, keeping the program name in argv[0]
+        argv[2] = argv[0];
+        argc -= 2;
+        argv += 2;
+    }
+    if (argc >= 2 && strcmp(argv[1], "--race") == 0)
+        return RaceAlgorithms();
+    if (argc >= 2 && strcmp(argv[1], "--parallel") == 0)
+        return ParallelAlgorithms();
+    if (argc >= 3 && strcmp(argv[1], "--sat") == 0)
+        return SolveFormulas(argc, argv);
+    if (argc >= 3 && strcmp(argv[1], "--portfolio") == 0)
+        return SolveFormulasPortfolio(argc, argv);
+    if (argc >= 2)
+        return ReplayTraces(argc, argv);
+
+    // choose delay times for about 30 seconds per algorithm from earlier runs
+    BlinkenSort::Calibration calibration(/* target */ 30);
+    calibration.open("blinken-sort-calibration.txt");
+    calibration.install();
+    if (s_hash_stats_path)
+        BlinkenHashtable::HashStatsHook = AppendHashStats;
+
     while (1) {
         RunRandomAlgorithmAnimation(my_strip);
     }
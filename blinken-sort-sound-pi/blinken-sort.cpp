@@ -12,6 +12,7 @@
 #include <linux/input.h>
 #include <SDL.h>
 
+#include <BlinkenAlgorithms/Animation/Calibration.hpp>
 #include <BlinkenAlgorithms/Animation/Hashtable.hpp>
 #include <BlinkenAlgorithms/Animation/LawaSAT.hpp>
 #include <BlinkenAlgorithms/Animation/Sort.hpp>
@@ -94,7 +95,8 @@ void RunRandomAlgorithm(LEDStrip& strip) {
         RunSort(strip, "Cocktail-Shaker Sort", CocktailShakerSort, -50); // 58 secs
         break;
     case 17:
-        RunSort(strip, "BozoSort", BozoSort, -4); // 20 secs (break time)
+        // runs for a fixed time, hence not calibrated
+        RunSort(strip, "BozoSort", BozoSort, -4, /* calibrate */ false); // 20 secs (break time)
         break;
 
     /*------------------------------------------------------------------------*/
@@ -115,15 +117,27 @@ void RunRandomAlgorithm(LEDStrip& strip) {
         RunHash(strip, "Cuckoo Three\nHash Table",  // 35 secs
                 CuckooHashingThree, 6000);
         break;
+    case 22:
+        RunHash(strip, "Robin Hood\nHash Table", // 28 secs
+                RobinHoodHT, -2);
+        break;
+    case 23:
+        RunHash(strip, "Hopscotch\nHash Table", // 42 secs
+                HopscotchHT, 0);
+        break;
+    case 24:
+        RunHash(strip, "Swiss Table\nHash Table", // 35 secs
+                SwissTableHT, 64000);
+        break;
 
     /*------------------------------------------------------------------------*/
 
-    case 22:
+    case 25:
         // RunLawaSAT(strip);
         break;
     }
     ++a;
-    a %= 22;
+    a %= 25;
 }
 
 /******************************************************************************/
@@ -150,6 +164,18 @@ void OnAlgorithmName(const char* name) {
     OnComparisonCount(0);
 }
 
+//! CSV file for hash statistics, set by --hash-stats <file>
+static const char* s_hash_stats_path = nullptr;
+
+//! append the workload statistics of each hash animation to a CSV file
+void AppendHashStats(const char* name, size_t n) {
+    FILE* f = fopen(s_hash_stats_path, "a");
+    if (!f)
+        return;
+    BlinkenHashtable::WriteHashStatsCSV(f, name, n, ftell(f) == 0);
+    fclose(f);
+}
+
 int fd_kbd = -1;
 
 static const char* const ev_value_text[3] = {
@@ -280,9 +306,13 @@ void wait_forever() {
     }
 }
 
-int main() {
+int main(int argc, char* argv[]) {
     srandom(123456);
 
+    // the animation loop writes no files unless asked to collect statistics
+    if (argc >= 3 && strcmp(argv[1], "--hash-stats") == 0)
+        s_hash_stats_path = argv[2];
+
     // ---[ Open USB Keyboard ]-------------------------------------------------
 
     const char* dev = "/dev/input/by-id/usb-_USB_Keyboard-event-kbd";
@@ -334,6 +364,13 @@ int main() {
     BlinkenSort::ComparisonCountHook = OnComparisonCount;
     BlinkenSort::AlgorithmNameHook = OnAlgorithmName;
 
+    // choose delay times for about 30 seconds per algorithm from earlier runs
+    BlinkenSort::Calibration calibration(/* target */ 30);
+    calibration.open("blinken-sort-calibration.txt");
+    calibration.install();
+    if (s_hash_stats_path)
+        BlinkenHashtable::HashStatsHook = AppendHashStats;
+
     using namespace BlinkenSort;
 
     while (1) {
@@ -356,19 +393,23 @@ int main() {
                 break;
 
             case Mode::InsertionSort:
-                RunSort(my_strip, "Insertion Sort", InsertionSort, -21);
+                RunSort(my_strip, "Insertion Sort", InsertionSort, -21,
+                        /* calibrate */ false);
                 wait_forever();
                 break;
             case Mode::QuickSortFast:
-                RunSort(my_strip, "QuickSort LR", QuickSortLR, -21);
+                RunSort(my_strip, "QuickSort LR", QuickSortLR, -21,
+                        /* calibrate */ false);
                 wait_forever();
                 break;
             case Mode::QuickSortSlow:
-                RunSort(my_strip, "QuickSort LR", QuickSortLR, 10);
+                RunSort(my_strip, "QuickSort LR", QuickSortLR, 10,
+                        /* calibrate */ false);
                 wait_forever();
                 break;
             case Mode::MergeSort:
-                RunSort(my_strip, "Merge Sort", MergeSort, 10);
+                RunSort(my_strip, "Merge Sort", MergeSort, 10,
+                        /* calibrate */ false);
                 wait_forever();
                 break;
             }
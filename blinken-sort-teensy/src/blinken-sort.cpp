@@ -10,9 +10,13 @@
 
 #include <BlinkenAlgorithms/Porting/Teensy.hpp>
 
+#include <BlinkenAlgorithms/Animation/Calibration.hpp>
 #include <BlinkenAlgorithms/Animation/RandomAlgorithm.hpp>
 #include <BlinkenAlgorithms/Strip/OctoSK6812Adapter.hpp>
 
+// generated on the Pi with: calibrate -s 12000 -H calibration-table.hpp 2400
+#include "calibration-table.hpp"
+
 using namespace BlinkenAlgorithms;
 
 /******************************************************************************/
@@ -32,6 +36,12 @@ Strip strip(base_strip, /* active_parts */ 8);
 bool g_terminate = false;
 size_t g_delay_factor = 1000;
 
+// delay times for about 30 seconds per algorithm, refined after each run
+BlinkenSort::Calibration calibration(
+    s_calibration_table,
+    sizeof(s_calibration_table) / sizeof(s_calibration_table[0]),
+    /* target */ 30);
+
 void delay_poll() { }
 
 void setup() {
@@ -46,6 +56,8 @@ void setup() {
     srandom(seed);
 
     base_strip.begin();
+
+    calibration.install();
 }
 
 void loop() {
@@ -0,0 +1,27 @@
+// generated by BlinkenSort::Calibration::write_table()
+static constexpr BlinkenSort::CalibrationEntry s_calibration_table[] = {
+    { "MergeSort", 2400, 51055, 12000.0f },
+    { "Insertion Sort", 2400, 4177566, 12000.0f },
+    { "QuickSort (LR)\nHoare", 2400, 57814, 12000.0f },
+    { "QuickSort (LL)\nLomoto", 2400, 64895, 12000.0f },
+    { "QuickSort\nDual Pivot", 2400, 54076, 12000.0f },
+    { "ShellSort", 2400, 79454, 12000.0f },
+    { "HeapSort", 2400, 96483, 12000.0f },
+    { "CycleSort", 2400, 7176, 12000.0f },
+    { "RadixSort-MSD\n(High First)", 2400, 58842, 12000.0f },
+    { "RadixSort-LSD\n(Low First)", 2400, 14400, 12000.0f },
+    { "std::sort", 2400, 50167, 12000.0f },
+    { "std::stable_sort", 2400, 33911, 12000.0f },
+    { "WikiSort", 2400, 134404, 12000.0f },
+    { "TimSort", 2400, 54106, 12000.0f },
+    { "Selection Sort", 2400, 2883598, 12000.0f },
+    { "Bubble Sort", 2400, 5677838, 12000.0f },
+    { "Cocktail-Shaker Sort", 2400, 4673026, 12000.0f },
+    { "Linear Probe\nHash Table", 2400, 15021, 12000.0f },
+    { "Quadratic Probe Hash Table", 2400, 9038, 12000.0f },
+    { "Cuckoo Two\nHash Table", 2400, 5806, 12000.0f },
+    { "Cuckoo Three\nHash Table", 2400, 28366, 12000.0f },
+    { "Robin Hood\nHash Table", 2400, 17476, 12000.0f },
+    { "Hopscotch\nHash Table", 2400, 14674, 12000.0f },
+    { "Swiss Table\nHash Table", 2400, 2160, 12000.0f },
+};
@@ -0,0 +1,308 @@
+/*******************************************************************************
+ * lib/BlinkenAlgorithms/BlinkenAlgorithms/Animation/Calibration.hpp
+ *
+ * Automatic delay_time calibration for RunSort and RunHash: measure the steps
+ * and the time per frame of each algorithm and strip size, and choose the
+ * delay_time for a target running time from them.
+ *
+ * Copyright (C) 2018 Timo Bingmann <tb@panthema.net>
+ *
+ * All rights reserved. Published under the GNU General Public License v3.0
+ ******************************************************************************/
+
+#ifndef BLINKENALGORITHMS_ANIMATION_CALIBRATION_HEADER
+#define BLINKENALGORITHMS_ANIMATION_CALIBRATION_HEADER
+
+#include <BlinkenAlgorithms/Animation/Sort.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace BlinkenSort {
+
+//! calibration of one algorithm and strip size, as in generated tables
+struct CalibrationEntry {
+    //! algorithm name as passed to RunSort or RunHash
+    const char* name;
+    //! strip size
+    uint32_t n;
+    //! number of delayed flashes
+    uint32_t steps;
+    //! microseconds to compute and show a frame, without the delay
+    float frame_us;
+};
+
+/*!
+ * Store of the steps and the frame time measured for each algorithm name and
+ * strip size. install() sets DelayTimeHook and RunTimeHook, such that RunSort
+ * and RunHash ask for the delay_time and report each run. The first run of an
+ * algorithm uses the delay_time given by the caller.
+ *
+ * With a target time T per algorithm, the delay is T / steps - frame_us per
+ * step, or if frames are too slow for that, a frame drop count of
+ * steps * frame_us / T.
+ *
+ * On the Pi, the store is loaded from and saved to a small text file. For
+ * embedded builds, write_table() generates a header with a constexpr table of
+ * CalibrationEntry, which is passed to the constructor.
+ */
+class Calibration
+{
+public:
+    //! empty calibration for the given target time per algorithm in seconds
+    explicit Calibration(double target = 30)
+        : target_(target) { }
+
+    //! calibration from a generated table
+    Calibration(const CalibrationEntry* table, size_t size,
+                double target = 30)
+        : target_(target) {
+        for (size_t i = 0; i < size; ++i) {
+            entries_.push_back(
+                Entry { table[i].name, table[i].n,
+                        table[i].steps, table[i].frame_us });
+        }
+    }
+
+    ~Calibration() {
+        if (s_installed == this)
+            uninstall();
+    }
+
+    //! target running time per algorithm in seconds
+    double target() const { return target_; }
+    void set_target(double target) { target_ = target; }
+
+    //! number of calibrated algorithms and strip sizes
+    size_t size() const { return entries_.size(); }
+
+    //! set the frame time of all entries, e.g. of the target hardware.
+    void set_frame_us(float frame_us) {
+        for (Entry& e : entries_)
+            e.frame_us = frame_us;
+    }
+
+    //! delay_time for an algorithm, or default_delay if not calibrated.
+    int32_t delay_time(const char* name, size_t n,
+                       int32_t default_delay) const {
+        const Entry* e = find(name, n);
+        if (!e || e->steps == 0)
+            return default_delay;
+
+        double per_step = target_ * 1e6 / e->steps;
+        if (per_step >= e->frame_us) {
+            return static_cast<int32_t>(
+                std::min<double>(per_step - e->frame_us, INT32_MAX));
+        }
+
+        // show frame_drop steps per frame
+        double frame_drop = std::ceil(e->steps * e->frame_us / (target_ * 1e6));
+        return -static_cast<int32_t>(std::min<double>(frame_drop, INT32_MAX));
+    }
+
+    //! record a run with delay_time which took seconds for steps
+    void update(const char* name, size_t n, uint64_t steps, double seconds,
+                int32_t delay_time) {
+        if (steps == 0)
+            return;
+
+        // frames shown and the time spent in delays
+        double frames = steps, delays = 0;
+        if (delay_time < 0)
+            frames = std::max(1.0, std::floor(steps / -delay_time));
+        else
+            delays = steps * (delay_time * g_delay_factor / 1000.0);
+
+        float frame_us = std::max(0.0, (seconds * 1e6 - delays) / frames);
+
+        Entry* e = find(name, n);
+        if (!e) {
+            entries_.push_back(Entry { name, n, steps, frame_us });
+        }
+        else {
+            e->steps = steps;
+            // average with previous runs
+            e->frame_us = (e->frame_us + frame_us) / 2;
+        }
+
+#if !ESP8266 && !TEENSYDUINO
+        if (!path_.empty())
+            save(path_.c_str());
+#endif
+    }
+
+    //! set DelayTimeHook and RunTimeHook to this calibration
+    void install() {
+        s_installed = this;
+        DelayTimeHook = &Calibration::OnDelayTime;
+        RunTimeHook = &Calibration::OnRunTime;
+    }
+
+    //! remove the hooks of any calibration
+    static void uninstall() {
+        s_installed = nullptr;
+        DelayTimeHook = nullptr;
+        RunTimeHook = nullptr;
+    }
+
+#if !ESP8266 && !TEENSYDUINO
+    /*!
+     * Load the calibration from a file if it exists, and save it there after
+     * each update. The file contains one line per entry: name, n, steps and
+     * frame_us, separated by tabs, with newlines in names written as \n.
+     */
+    void open(const char* path) {
+        path_ = path;
+        load(path);
+    }
+
+    //! load entries from a file, replacing entries of the same name and size
+    bool load(const char* path) {
+        FILE* f = fopen(path, "r");
+        if (!f)
+            return false;
+
+        char line[256];
+        while (fgets(line, sizeof(line), f)) {
+            if (line[0] == '#')
+                continue;
+            char* tab = strchr(line, '\t');
+            if (!tab)
+                continue;
+            *tab = 0;
+
+            unsigned long n, steps;
+            float frame_us;
+            if (sscanf(tab + 1, "%lu\t%lu\t%f", &n, &steps, &frame_us) != 3)
+                continue;
+
+            std::string name = unescape(line);
+            Entry* e = find(name.c_str(), n);
+            if (!e) {
+                entries_.push_back(Entry { name, n, steps, frame_us });
+            }
+            else {
+                e->steps = steps;
+                e->frame_us = frame_us;
+            }
+        }
+        fclose(f);
+        return true;
+    }
+
+    //! save all entries to a file
+    bool save(const char* path) const {
+        FILE* f = fopen(path, "w");
+        if (!f)
+            return false;
+        fprintf(f, "# name\tn\tsteps\tframe_us\n");
+        for (const Entry& e : entries_) {
+            fprintf(f, "%s\t%zu\t%lu\t%.1f\n", escape(e.name).c_str(), e.n,
+                    static_cast<unsigned long>(e.steps), e.frame_us);
+        }
+        return fclose(f) == 0;
+    }
+
+    //! write a header with a constexpr table for embedded builds
+    bool write_table(const char* path, const char* table_name) const {
+        FILE* f = fopen(path, "w");
+        if (!f)
+            return false;
+        fprintf(f, "// generated by BlinkenSort::Calibration::write_table()\n"
+                "static constexpr BlinkenSort::CalibrationEntry %s[] = {\n",
+                table_name);
+        for (const Entry& e : entries_) {
+            fprintf(f, "    { \"%s\", %zu, %lu, %.1ff },\n",
+                    escape(e.name).c_str(), e.n,
+                    static_cast<unsigned long>(e.steps), e.frame_us);
+        }
+        fprintf(f, "};\n");
+        return fclose(f) == 0;
+    }
+#endif
+
+private:
+    struct Entry {
+        std::string name;
+        size_t n;
+        uint64_t steps;
+        float frame_us;
+    };
+
+    //! target running time per algorithm in seconds
+    double target_;
+
+    std::vector<Entry> entries_;
+
+#if !ESP8266 && !TEENSYDUINO
+    //! file to save to after each update
+    std::string path_;
+#endif
+
+    //! calibration used by the hooks
+    static Calibration* s_installed;
+
+    const Entry* find(const char* name, size_t n) const {
+        for (const Entry& e : entries_) {
+            if (e.n == n && e.name == name)
+                return &e;
+        }
+        return nullptr;
+    }
+
+    Entry* find(const char* name, size_t n) {
+        return const_cast<Entry*>(
+            static_cast<const Calibration*>(this)->find(name, n));
+    }
+
+    //! write newlines in names as \n, such that entries stay on one line
+    static std::string escape(const std::string& name) {
+        std::string out;
+        for (char c : name) {
+            if (c == '\n')
+                out += "\\n";
+            else if (c == '\\' || c == '"')
+                out += '\\', out += c;
+            else
+                out += c;
+        }
+        return out;
+    }
+
+    static std::string unescape(const char* name) {
+        std::string out;
+        for (const char* p = name; *p; ++p) {
+            if (*p == '\\' && p[1])
+                out += (*++p == 'n') ? '\n' : *p;
+            else
+                out += *p;
+        }
+        return out;
+    }
+
+    static int32_t OnDelayTime(const char* name, size_t n,
+                               int32_t delay_time) {
+        if (!s_installed)
+            return delay_time;
+        return s_installed->delay_time(name, n, delay_time);
+    }
+
+    static void OnRunTime(const char* name, size_t n, uint64_t steps,
+                          double seconds, int32_t delay_time) {
+        if (s_installed)
+            s_installed->update(name, n, steps, seconds, delay_time);
+    }
+};
+
+Calibration* Calibration::s_installed = nullptr;
+
+} // namespace BlinkenSort
+
+#endif // !BLINKENALGORITHMS_ANIMATION_CALIBRATION_HEADER
+
+/******************************************************************************/
@@ -13,12 +13,263 @@
 #include <BlinkenAlgorithms/Color.hpp>
 
 #include <cassert>
+#include <cstdint>
+#include <cstdio>
 #include <random>
 #include <vector>
 
+#if __SSE2__
+#include <emmintrin.h>
+#endif
+
 namespace BlinkenHashtable {
 
 using namespace BlinkenSort;
+using BlinkenAlgorithms::micros;
+
+/******************************************************************************/
+// Workload and Probe Statistics
+
+//! phases of a hash table workload
+enum HashPhase {
+    HASH_INSERT,    //!< insert keys up to the load factor
+    HASH_FIND_HIT,  //!< look up inserted keys
+    HASH_FIND_MISS, //!< look up absent keys
+    HASH_ERASE,     //!< delete inserted keys
+    HASH_PHASES
+};
+
+const char* HashPhaseName(HashPhase phase) {
+    static const char* names[HASH_PHASES] = {
+        "insert", "hit", "miss", "erase"
+    };
+    return phase < HASH_PHASES ? names[phase] : "";
+}
+
+/*!
+ * Workload of the hash table algorithms: insert keys up to load_percent of the
+ * slots, then look up hit_percent of them at random, miss_percent absent keys,
+ * and delete erase_percent of the inserted keys. Deleted slots of the probing
+ * tables become tombstones, Robin Hood hashing shifts back instead.
+ *
+ * The default only inserts, which is what the animation cycle's delay times
+ * are tuned for. hash-benchmark enables the other phases.
+ */
+struct HashWorkload {
+    //! fill factor in percent of the slots, 0 for each table's default
+    size_t load_percent = 0;
+    //! lookups and deletions in percent of the inserted keys
+    size_t hit_percent = 0, miss_percent = 0, erase_percent = 0;
+};
+
+//! workload of the hash algorithms
+BLINKEN_THREAD_LOCAL HashWorkload g_hash_workload;
+
+//! number of probe length histogram buckets, the last collects longer ones
+static const size_t s_hash_histogram = 32;
+
+//! probe statistics of one phase, summed over all its operations
+struct HashStats {
+    //! number of operations
+    size_t operations = 0;
+    //! slots inspected, for SwissTableHT the groups of slots inspected
+    size_t probes = 0;
+    //! cache lines of the table or its metadata touched, counting a line again
+    //! if the operation returns to it
+    size_t cache_lines = 0;
+    //! key comparisons
+    size_t comparisons = 0;
+    //! longest probe sequence of an operation
+    size_t max_probes = 0;
+    //! largest distance of a placed item from its first probe, in probe steps
+    size_t max_displacement = 0;
+    //! items in the table after the phase
+    size_t items = 0;
+    //! time taken by the phase
+    double seconds = 0;
+    //! operations by number of probes
+    size_t histogram[s_hash_histogram] = { };
+};
+
+//! statistics of the current hash workload, cleared by RunHash
+BLINKEN_THREAD_LOCAL HashStats g_hash_stats[HASH_PHASES];
+
+//! phase of the current hash workload
+BLINKEN_THREAD_LOCAL HashPhase g_hash_phase = HASH_INSERT;
+
+void ClearHashStats() {
+    for (size_t p = 0; p < HASH_PHASES; ++p)
+        g_hash_stats[p] = HashStats();
+}
+
+//! size of a cache line in bytes
+static const size_t s_cache_line = 64;
+
+//! counts the probes, comparisons and cache lines touched by one operation
+//! into the g_hash_stats of the current phase
+class ProbeCounter
+{
+public:
+    ProbeCounter() : stats_(g_hash_stats[g_hash_phase]) {
+        ++stats_.operations;
+    }
+
+    ~ProbeCounter() {
+        stats_.max_probes = std::max(stats_.max_probes, probes_);
+        ++stats_.histogram[std::min(probes_, s_hash_histogram - 1)];
+    }
+
+    //! count a probe of slot A[idx]
+    template <typename Item>
+    void slot(const Item* A, size_t idx) {
+        ++probes_, ++stats_.probes;
+        touch(A + idx);
+    }
+
+    //! count a probe of the metadata of a group of slots at p
+    void group(const void* p) {
+        ++probes_, ++stats_.probes;
+        touch(p);
+    }
+
+    //! count reading memory at p, which is not a probe by itself
+    void touch(const void* p) {
+        uintptr_t line = reinterpret_cast<uintptr_t>(p) / s_cache_line;
+        if (line != line_) {
+            ++stats_.cache_lines;
+            line_ = line;
+        }
+    }
+
+    //! compare the item in a slot with the key
+    template <typename Item>
+    bool compare(const Item& a, const Item& key) {
+        ++stats_.comparisons;
+        return a == key;
+    }
+
+    //! record an item placed d probe steps after its first probe
+    void place(size_t d) {
+        stats_.max_displacement = std::max(stats_.max_displacement, d);
+    }
+
+private:
+    HashStats& stats_;
+
+    //! probes of this operation
+    size_t probes_ = 0;
+
+    //! last cache line touched
+    uintptr_t line_ = uintptr_t(-1);
+};
+
+//! finish the current phase started at ts with items in the table, and return
+//! the start time of the next one
+unsigned long FinishHashPhase(unsigned long ts, size_t items) {
+    unsigned long now = micros();
+    g_hash_stats[g_hash_phase].seconds += (now - ts) / 1e6;
+    g_hash_stats[g_hash_phase].items = items;
+    return now;
+}
+
+/*!
+ * Run g_hash_workload on a Table over the n slots of A. Keys are the values
+ * [0,n) in a random rotation, the first m are inserted and the remaining ones
+ * are the absent keys. Inserting stops early when the table is full.
+ */
+template <template <typename> class Table, typename Item>
+void RunHashWorkload(Item* A, size_t n) {
+    const HashWorkload& w = g_hash_workload;
+    Table<Item> table(A, n);
+
+    size_t load = w.load_percent;
+    if (load == 0)
+        load = Table<Item>::default_load;
+
+    // key i is the item (i + cshift) % n
+    size_t cshift = random(n);
+    size_t m = n * load / 100, items = 0;
+    unsigned long ts = micros();
+
+    g_hash_phase = HASH_INSERT;
+    for (size_t i = 0; i < m && !g_terminate; ++i) {
+        if (!table.insert(Item((i + cshift) % n))) {
+            // the table is full. stop inserting.
+            m = i;
+            break;
+        }
+        ++items;
+        Item::IncrementCounter();
+    }
+    ts = FinishHashPhase(ts, items);
+
+    g_hash_phase = HASH_FIND_HIT;
+    size_t hits = m != 0 ? m * w.hit_percent / 100 : 0;
+    for (size_t j = 0; j < hits && !g_terminate; ++j) {
+        table.find(Item((random(m) + cshift) % n));
+        Item::IncrementCounter();
+    }
+    ts = FinishHashPhase(ts, items);
+
+    g_hash_phase = HASH_FIND_MISS;
+    size_t misses = m != n ? m * w.miss_percent / 100 : 0;
+    for (size_t j = 0; j < misses && !g_terminate; ++j) {
+        table.find(Item((m + random(n - m) + cshift) % n));
+        Item::IncrementCounter();
+    }
+    ts = FinishHashPhase(ts, items);
+
+    // spread the deleted keys evenly over the inserted ones
+    g_hash_phase = HASH_ERASE;
+    size_t erases = m * std::min<size_t>(w.erase_percent, 100) / 100;
+    for (size_t j = 0; j < erases && !g_terminate; ++j) {
+        if (table.erase(Item((j * m / erases + cshift) % n)))
+            --items;
+        Item::IncrementCounter();
+    }
+    FinishHashPhase(ts, items);
+
+    g_hash_phase = HASH_INSERT;
+}
+
+#if !ESP8266 && !TEENSYDUINO
+/*!
+ * Write the statistics of the last workload as CSV, one row per phase that
+ * ran, preceded by a header row if header is set.
+ */
+void WriteHashStatsCSV(FILE* f, const char* name, size_t n,
+                       bool header = false) {
+    if (header) {
+        fprintf(f, "algorithm,n,phase,load,operations,seconds,"
+                "probes,cache_lines,comparisons,max_probes,max_displacement");
+        for (size_t h = 0; h < s_hash_histogram; ++h)
+            fprintf(f, ",probes_%zu%s", h, h + 1 == s_hash_histogram ? "+" : "");
+        fprintf(f, "\n");
+    }
+
+    for (size_t p = 0; p < HASH_PHASES; ++p) {
+        const HashStats& s = g_hash_stats[p];
+        if (s.operations == 0)
+            continue;
+        // names may contain newlines for the display
+        fputc('"', f);
+        for (const char* c = name; *c; ++c)
+            fputc(*c == '\n' ? ' ' : *c == '"' ? '\'' : *c, f);
+        fprintf(f, "\",%zu,%s,%.4f,%zu,%.6f,%zu,%zu,%zu,%zu,%zu",
+                n, HashPhaseName(HashPhase(p)),
+                n ? s.items / double(n) : 0.0, s.operations, s.seconds,
+                s.probes, s.cache_lines, s.comparisons, s.max_probes,
+                s.max_displacement);
+        for (size_t h = 0; h < s_hash_histogram; ++h)
+            fprintf(f, ",%zu", s.histogram[h]);
+        fprintf(f, "\n");
+    }
+}
+#endif
+
+//! receives the name and size of each finished RunHash, whose statistics are
+//! in g_hash_stats, e.g. to append them with WriteHashStatsCSV().
+static void (* HashStatsHook)(const char* name, size_t n) = nullptr;
 
 /******************************************************************************/
 // Hashing with Linear Probing
@@ -33,49 +284,137 @@ uint32_t hash(uint32_t a) {
     return a;
 }
 
-void LinearProbingHT(Item* A, size_t n) {
+//! home slot of a value in a table of n slots with linear probing
+size_t hash_home(uint32_t a, size_t n) {
+    return (hash(a) >> 2) % n;
+}
 
-    size_t cshift = random(n);
+template <typename Item>
+class LinearProbingTable
+{
+public:
+    static const size_t default_load = 90;
+
+    LinearProbingTable(Item* A, size_t n) : A(A), n(n) { }
+
+    bool insert(const Item& v) {
+        ProbeCounter probe;
+        size_t idx = hash_home(v.value(), n);
+        for (size_t d = 0; d < n; ++d) {
+            probe.slot(A, idx);
+            if (A[idx].value() >= Item::tombstone) {
+                A[idx] = v;
+                probe.place(d);
+                return true;
+            }
+            idx = (idx + 1) % n;
+        }
+        return false;
+    }
 
-    for (size_t i = 0; i < n * 90 / 100; ++i) {
-        // pick a new item to insert
-        Item v = Item((i + cshift) % n);
+    bool find(const Item& v) {
+        ProbeCounter probe;
+        return locate(v, probe) != n;
+    }
 
-        size_t idx = (hash(v.value()) >> 2) % n;
-        while (A[idx].value() != black) {
+    bool erase(const Item& v) {
+        ProbeCounter probe;
+        size_t idx = locate(v, probe);
+        if (idx == n)
+            return false;
+        A[idx] = Item(Item::tombstone);
+        return true;
+    }
+
+private:
+    Item* A;
+    size_t n;
+
+    //! slot of v or n, probing over tombstones until an empty slot
+    size_t locate(const Item& v, ProbeCounter& probe) {
+        size_t idx = hash_home(v.value(), n);
+        for (size_t d = 0; d < n; ++d) {
+            probe.slot(A, idx);
+            typename Item::value_type x = A[idx].value();
+            if (x == Item::black)
+                return n;
+            if (x != Item::tombstone && probe.compare(A[idx], v))
+                return idx;
             idx = (idx + 1) % n;
         }
-        A[idx] = v;
-
-        A[idx].IncrementCounter();
+        return n;
     }
+};
+
+template <typename Item>
+void LinearProbingHT(Item* A, size_t n) {
+    RunHashWorkload<LinearProbingTable>(A, n);
 }
 
 /******************************************************************************/
 // Hashing with Quadratic Probing
 
-void QuadraticProbingHT(Item* A, size_t n) {
-
-    size_t cshift = random(n);
+template <typename Item>
+class QuadraticProbingTable
+{
+public:
+    static const size_t default_load = 90;
 
-    for (size_t i = 0; i < n * 90 / 100; ++i) {
-        // pick a new item to insert
-        Item v = Item((i + cshift) % n);
+    QuadraticProbingTable(Item* A, size_t n) : A(A), n(n) { }
 
+    bool insert(const Item& v) {
+        ProbeCounter probe;
         size_t idx = (hash(v.value()) >> 2) % n;
-        size_t p = 0;
-        while (A[idx].value() != black) {
-            idx = (idx + (p + p * p) / 2) % n;
-            ++p;
-            if (p == n) {
-                // cycled. stop hashing.
-                return;
+        for (size_t p = 0; p < n; ++p) {
+            probe.slot(A, idx);
+            if (A[idx].value() >= Item::tombstone) {
+                A[idx] = v;
+                probe.place(p);
+                return true;
             }
+            idx = (idx + (p + p * p) / 2) % n;
         }
-        A[idx] = v;
+        // cycled. stop hashing.
+        return false;
+    }
+
+    bool find(const Item& v) {
+        ProbeCounter probe;
+        return locate(v, probe) != n;
+    }
+
+    bool erase(const Item& v) {
+        ProbeCounter probe;
+        size_t idx = locate(v, probe);
+        if (idx == n)
+            return false;
+        A[idx] = Item(Item::tombstone);
+        return true;
+    }
+
+private:
+    Item* A;
+    size_t n;
 
-        A[idx].IncrementCounter();
+    //! slot of v or n, probing over tombstones until an empty slot
+    size_t locate(const Item& v, ProbeCounter& probe) {
+        size_t idx = (hash(v.value()) >> 2) % n;
+        for (size_t p = 0; p < n; ++p) {
+            probe.slot(A, idx);
+            typename Item::value_type x = A[idx].value();
+            if (x == Item::black)
+                return n;
+            if (x != Item::tombstone && probe.compare(A[idx], v))
+                return idx;
+            idx = (idx + (p + p * p) / 2) % n;
+        }
+        return n;
     }
+};
+
+template <typename Item>
+void QuadraticProbingHT(Item* A, size_t n) {
+    RunHashWorkload<QuadraticProbingTable>(A, n);
 }
 
 /******************************************************************************/
@@ -89,45 +428,83 @@ uint32_t hash2(int f, uint32_t a) {
     return 0;
 }
 
-void CuckooHashingTwo(Item* A, size_t n) {
-
-    size_t cshift = random(n);
+template <typename Item>
+class CuckooTwoTable
+{
+public:
+    static const size_t default_load = 100;
 
-    for (size_t i = 0; i < n; ++i) {
-        // pick a new item to insert
-        Item v = Item((i + cshift) % n);
+    CuckooTwoTable(Item* A, size_t n) : A(A), n(n) { }
 
+    bool insert(Item v) {
+        ProbeCounter probe;
         uint32_t pos = hash2(0, v.value()) % n;
-        if (A[pos].value() == black) {
+        probe.slot(A, pos);
+        if (A[pos].value() == Item::black) {
             A[pos] = v;
-            A[pos].IncrementCounter();
-            continue;
+            return true;
         }
 
         pos = hash2(1, v.value()) % n;
-        if (A[pos].value() == black) {
+        probe.slot(A, pos);
+        if (A[pos].value() == Item::black) {
             A[pos] = v;
-            A[pos].IncrementCounter();
-            continue;
+            probe.place(1);
+            return true;
         }
 
         size_t r = 0;
         int hashfunction = 1;
         while (true) {
             pos = hash2(hashfunction, v.value()) % n;
+            probe.slot(A, pos);
             swap(v, A[pos]);
-            if (v.value() == black)
+            if (v.value() == Item::black)
                 break;
 
             if (hash2(hashfunction, v.value()) % n == pos)
                 hashfunction = (hashfunction + 1) % 2;
 
             if (++r >= n)
-                return;
+                return false;
         }
+        probe.place(r + 2);
+        return true;
+    }
+
+    bool find(const Item& v) {
+        ProbeCounter probe;
+        return locate(v, probe) != n;
+    }
+
+    bool erase(const Item& v) {
+        ProbeCounter probe;
+        size_t idx = locate(v, probe);
+        if (idx == n)
+            return false;
+        A[idx] = Item(Item::black);
+        return true;
+    }
 
-        A[pos].IncrementCounter();
+private:
+    Item* A;
+    size_t n;
+
+    //! slot of v or n, one of two choices
+    size_t locate(const Item& v, ProbeCounter& probe) {
+        for (int f = 0; f < 2; ++f) {
+            uint32_t pos = hash2(f, v.value()) % n;
+            probe.slot(A, pos);
+            if (probe.compare(A[pos], v))
+                return pos;
+        }
+        return n;
     }
+};
+
+template <typename Item>
+void CuckooHashingTwo(Item* A, size_t n) {
+    RunHashWorkload<CuckooTwoTable>(A, n);
 }
 
 /******************************************************************************/
@@ -143,38 +520,30 @@ uint32_t hash3(int f, uint32_t a, size_t n) {
     return 0;
 }
 
-void CuckooHashingThree(Item* A, size_t n) {
-
-    size_t cshift = random(n);
-
-    for (size_t i = 0; i < n; ++i) {
-        // pick a new item to insert
-        Item v = Item((i + cshift) % n);
-
-        uint32_t pos = hash3(0, v.value(), n);
-        if (A[pos].value() == black) {
-            A[pos] = v;
-            A[pos].IncrementCounter();
-            continue;
-        }
-
-        pos = hash3(1, v.value(), n);
-        if (A[pos].value() == black) {
-            A[pos] = v;
-            A[pos].IncrementCounter();
-            continue;
-        }
-
-        pos = hash3(2, v.value(), n);
-        if (A[pos].value() == black) {
-            A[pos] = v;
-            A[pos].IncrementCounter();
-            continue;
+template <typename Item>
+class CuckooThreeTable
+{
+public:
+    static const size_t default_load = 100;
+
+    CuckooThreeTable(Item* A, size_t n) : A(A), n(n) { }
+
+    bool insert(Item v) {
+        ProbeCounter probe;
+        for (int f = 0; f < 3; ++f) {
+            uint32_t pos = hash3(f, v.value(), n);
+            probe.slot(A, pos);
+            if (A[pos].value() == Item::black) {
+                A[pos] = v;
+                probe.place(f);
+                return true;
+            }
         }
 
         // all three places full, pick a random one to displace
         int hashfunction = random(3);
-        pos = hash3(hashfunction, v.value(), n);
+        uint32_t pos = hash3(hashfunction, v.value(), n);
+        probe.slot(A, pos);
         swap(v, A[pos]);
 
         size_t r = 0;
@@ -184,35 +553,415 @@ void CuckooHashingThree(Item* A, size_t n) {
                 hashfunction = 2;
 
             pos = hash3(hashfunction, v.value(), n);
+            probe.slot(A, pos);
             swap(v, A[pos]);
-            if (v.value() == black)
+            if (v.value() == Item::black)
                 break;
 
             if (++r >= n)
-                return;
+                return false;
+        }
+        probe.place(r + 3);
+        return true;
+    }
+
+    bool find(const Item& v) {
+        ProbeCounter probe;
+        return locate(v, probe) != n;
+    }
+
+    bool erase(const Item& v) {
+        ProbeCounter probe;
+        size_t idx = locate(v, probe);
+        if (idx == n)
+            return false;
+        A[idx] = Item(Item::black);
+        return true;
+    }
+
+private:
+    Item* A;
+    size_t n;
+
+    //! slot of v or n, one of three choices
+    size_t locate(const Item& v, ProbeCounter& probe) {
+        for (int f = 0; f < 3; ++f) {
+            uint32_t pos = hash3(f, v.value(), n);
+            probe.slot(A, pos);
+            if (probe.compare(A[pos], v))
+                return pos;
+        }
+        return n;
+    }
+};
+
+template <typename Item>
+void CuckooHashingThree(Item* A, size_t n) {
+    RunHashWorkload<CuckooThreeTable>(A, n);
+}
+
+/******************************************************************************/
+// Robin Hood Hashing (linear probing, where an inserted item displaces items
+// closer to their home slot, with backward shift deletion)
+
+template <typename Item>
+class RobinHoodTable
+{
+public:
+    static const size_t default_load = 90;
+
+    RobinHoodTable(Item* A, size_t n) : A(A), n(n) { }
+
+    bool insert(Item v) {
+        ProbeCounter probe;
+        size_t idx = hash_home(v.value(), n), dist = 0;
+        for (size_t p = 0; p < n; ++p) {
+            probe.slot(A, idx);
+            typename Item::value_type x = A[idx].value();
+            if (x == Item::black) {
+                A[idx] = v;
+                probe.place(dist);
+                return true;
+            }
+            // take the slot of an item closer to its home, and carry it on
+            size_t d = (idx + n - hash_home(x, n)) % n;
+            if (d < dist) {
+                swap(v, A[idx]);
+                probe.place(dist);
+                dist = d;
+            }
+            idx = (idx + 1) % n;
+            ++dist;
+        }
+        return false;
+    }
+
+    bool find(const Item& v) {
+        ProbeCounter probe;
+        return locate(v, probe) != n;
+    }
+
+    //! erase v by shifting the following items of its cluster back by one
+    //! slot, which needs no tombstones.
+    bool erase(const Item& v) {
+        ProbeCounter probe;
+        size_t idx = locate(v, probe);
+        if (idx == n)
+            return false;
+
+        A[idx] = Item(Item::black);
+
+        // shift back the following items until an empty slot or one at its
+        // home. Copy them, since a move would clear the source slot without
+        // showing it, and clear the last one explicitly.
+        while (true) {
+            size_t next = (idx + 1) % n;
+            probe.slot(A, next);
+            typename Item::value_type x = A[next].value();
+            if (x == Item::black || hash_home(x, n) == next)
+                break;
+            A[idx] = A[next];
+            idx = next;
+        }
+        if (A[idx].value() != Item::black)
+            A[idx] = Item(Item::black);
+        return true;
+    }
+
+private:
+    Item* A;
+    size_t n;
+
+    //! slot of v or n, stopping early at an item closer to its home
+    size_t locate(const Item& v, ProbeCounter& probe) {
+        size_t idx = hash_home(v.value(), n);
+        for (size_t dist = 0; dist < n; ++dist) {
+            probe.slot(A, idx);
+            typename Item::value_type x = A[idx].value();
+            if (x == Item::black)
+                return n;
+            // v would have displaced an item closer to its home
+            if ((idx + n - hash_home(x, n)) % n < dist)
+                return n;
+            if (probe.compare(A[idx], v))
+                return idx;
+            idx = (idx + 1) % n;
+        }
+        return n;
+    }
+};
+
+template <typename Item>
+void RobinHoodHT(Item* A, size_t n) {
+    RunHashWorkload<RobinHoodTable>(A, n);
+}
+
+/******************************************************************************/
+// Hopscotch Hashing (every item lies in the neighborhood of H slots starting
+// at its home slot, and a bitmap per home slot marks the slots of its items. A
+// free slot found by linear probing is moved back into the neighborhood by
+// hopping items within their own neighborhoods.)
+
+template <typename Item>
+class HopscotchTable
+{
+public:
+    static const size_t default_load = 90;
+    static const size_t H = 32;
+
+    HopscotchTable(Item* A, size_t n) : A(A), n(n), hop(n, 0) { }
+
+    bool insert(const Item& v) {
+        ProbeCounter probe;
+        size_t home = hash_home(v.value(), n);
+
+        // find a free slot by linear probing
+        size_t idx = home, dist = 0;
+        probe.slot(A, idx);
+        while (A[idx].value() != Item::black) {
+            idx = (idx + 1) % n;
+            probe.slot(A, idx);
+            if (++dist == n)
+                return false;
+        }
+
+        // hop the free slot back until it is in the neighborhood of home
+        while (dist >= H) {
+            bool hopped = false;
+            // farthest home slot first, whose neighborhood still reaches idx
+            for (size_t j = H - 1; j > 0 && !hopped; --j) {
+                size_t b = (idx + n - j) % n;
+                probe.touch(&hop[b]);
+                // move the first of its items which lies before idx
+                for (size_t k = 0; k < j; ++k) {
+                    if (!(hop[b] & (uint32_t(1) << k)))
+                        continue;
+                    size_t from = (b + k) % n;
+                    probe.slot(A, from);
+                    A[idx] = A[from];
+                    hop[b] = (hop[b] & ~(uint32_t(1) << k)) | (uint32_t(1) << j);
+                    idx = from;
+                    dist -= j - k;
+                    hopped = true;
+                    break;
+                }
+            }
+            if (!hopped) {
+                // the table would need to grow. stop hashing.
+                A[idx] = Item(Item::black);
+                return false;
+            }
+        }
+
+        A[idx] = v;
+        probe.touch(&hop[home]);
+        hop[home] |= uint32_t(1) << dist;
+        probe.place(dist);
+        return true;
+    }
+
+    bool find(const Item& v) {
+        ProbeCounter probe;
+        return locate(v, probe) != n;
+    }
+
+    bool erase(const Item& v) {
+        ProbeCounter probe;
+        size_t idx = locate(v, probe);
+        if (idx == n)
+            return false;
+        size_t home = hash_home(v.value(), n);
+        hop[home] &= ~(uint32_t(1) << ((idx + n - home) % n));
+        A[idx] = Item(Item::black);
+        return true;
+    }
+
+private:
+    Item* A;
+    size_t n;
+
+    //! bitmap of the slots in the neighborhood of each home slot
+    std::vector<uint32_t> hop;
+
+    //! slot of v or n, comparing only the slots marked in the bitmap
+    size_t locate(const Item& v, ProbeCounter& probe) {
+        size_t home = hash_home(v.value(), n);
+        probe.touch(&hop[home]);
+        for (uint32_t m = hop[home]; m; m &= m - 1) {
+            size_t idx = (home + __builtin_ctz(m)) % n;
+            probe.slot(A, idx);
+            if (probe.compare(A[idx], v))
+                return idx;
+        }
+        return n;
+    }
+};
+
+template <typename Item>
+void HopscotchHT(Item* A, size_t n) {
+    RunHashWorkload<HopscotchTable>(A, n);
+}
+
+/******************************************************************************/
+// Swiss Table Hashing (slots in groups of 16 with one control byte per slot,
+// which marks it as empty or deleted, or holds seven bits of the hash value.
+// All control bytes of a group are matched at once, with SSE2 where available,
+// such that only slots with matching bits are compared.)
+
+//! control byte of an empty slot
+static const uint8_t s_swiss_empty = 0x80;
+//! control byte of a deleted slot
+static const uint8_t s_swiss_deleted = 0xFE;
+
+//! bitmask of the bytes equal to c in the group of 16 control bytes
+uint32_t SwissGroupMatch(const uint8_t* group, uint8_t c) {
+#if __SSE2__
+    __m128i g = _mm_loadu_si128(reinterpret_cast<const __m128i*>(group));
+    return _mm_movemask_epi8(
+        _mm_cmpeq_epi8(g, _mm_set1_epi8(static_cast<char>(c))));
+#else
+    uint32_t mask = 0;
+    for (size_t i = 0; i < 16; ++i)
+        mask |= uint32_t(group[i] == c) << i;
+    return mask;
+#endif
+}
+
+template <typename Item>
+class SwissTable
+{
+public:
+    static const size_t default_load = 90;
+
+    //! slots after the last full group stay unused
+    SwissTable(Item* A, size_t n)
+        : A(A), groups(n / 16), ctrl(groups * 16, s_swiss_empty) { }
+
+    bool insert(const Item& v) {
+        ProbeCounter probe;
+        uint32_t h = hash(v.value());
+        size_t g = home(h);
+        for (size_t p = 0; p < groups; ++p) {
+            const uint8_t* group = ctrl.data() + g * 16;
+            probe.group(group);
+
+            uint32_t free = SwissGroupMatch(group, s_swiss_empty) |
+                            SwissGroupMatch(group, s_swiss_deleted);
+            if (free) {
+                size_t s = g * 16 + __builtin_ctz(free);
+                ctrl[s] = h & 0x7F;
+                probe.touch(A + s);
+                A[s] = v;
+                probe.place(p);
+                return true;
+            }
+
+            // probe the groups linearly
+            g = (g + 1) % groups;
+        }
+        // table is full. stop hashing.
+        return false;
+    }
+
+    bool find(const Item& v) {
+        ProbeCounter probe;
+        return locate(v, probe) != groups * 16;
+    }
+
+    bool erase(const Item& v) {
+        ProbeCounter probe;
+        size_t s = locate(v, probe);
+        if (s == groups * 16)
+            return false;
+        // a group with an empty slot never continued a probe sequence
+        const uint8_t* group = ctrl.data() + s / 16 * 16;
+        if (SwissGroupMatch(group, s_swiss_empty)) {
+            ctrl[s] = s_swiss_empty;
+            A[s] = Item(Item::black);
         }
+        else {
+            ctrl[s] = s_swiss_deleted;
+            A[s] = Item(Item::tombstone);
+        }
+        return true;
+    }
+
+private:
+    Item* A;
+    size_t groups;
+
+    //! control bytes of the slots
+    std::vector<uint8_t> ctrl;
+
+    //! high bits of the hash value select the group, the low seven are stored
+    size_t home(uint32_t h) const {
+        return (h >> 7) % groups;
+    }
+
+    //! slot of v or groups * 16
+    size_t locate(const Item& v, ProbeCounter& probe) {
+        uint32_t h = hash(v.value());
+        size_t g = home(h);
+        for (size_t p = 0; p < groups; ++p) {
+            const uint8_t* group = ctrl.data() + g * 16;
+            probe.group(group);
+
+            // compare only slots with matching bits
+            for (uint32_t m = SwissGroupMatch(group, h & 0x7F); m;
+                 m &= m - 1) {
+                size_t s = g * 16 + __builtin_ctz(m);
+                probe.touch(A + s);
+                if (probe.compare(A[s], v))
+                    return s;
+            }
+            if (SwissGroupMatch(group, s_swiss_empty))
+                break;
 
-        A[pos].IncrementCounter();
+            g = (g + 1) % groups;
+        }
+        return groups * 16;
     }
+};
+
+template <typename Item>
+void SwissTableHT(Item* A, size_t n) {
+    if (n < 16)
+        return;
+    RunHashWorkload<SwissTable>(A, n);
 }
 
 /******************************************************************************/
 
-template <typename LEDStrip>
+template <typename LEDStrip, typename ItemType = Item>
 void RunHash(LEDStrip& strip, const char* algo_name,
-             void (*hash_function)(Item* A, size_t n),
-             int32_t delay_time = 10000) {
+             void (*hash_function)(ItemType* A, size_t n),
+             int32_t delay_time = 10000, bool calibrate = true) {
 
     // printf("%s delay time: %d\n", algo_name, delay_time);
 
     uint32_t ts = millis();
-    SortAnimation<LEDStrip> ani(strip, delay_time);
+
+    if (calibrate && DelayTimeHook)
+        delay_time = DelayTimeHook(algo_name, strip.size(), delay_time);
+
+    SortAnimation<LEDStrip, ItemType> ani(strip, delay_time);
     if (AlgorithmNameHook)
         AlgorithmNameHook(algo_name);
     ani.array_black();
-    hash_function(array.data(), array.size());
 
-    static double total_time = 0, total_count = 0;
+    ClearHashStats();
+
+    uint64_t steps = ani.step_count();
+    unsigned long ts_hash = micros();
+    hash_function(SortArray<ItemType>().data(), SortArray<ItemType>().size());
+
+    if (calibrate && RunTimeHook) {
+        RunTimeHook(algo_name, array_size, ani.step_count() - steps,
+                    static_cast<unsigned long>(micros() - ts_hash) / 1e6,
+                    delay_time);
+    }
+
+    static BLINKEN_THREAD_LOCAL double total_time = 0, total_count = 0;
     total_time += (millis() - ts) / 1000.0;
     total_count += 1;
 
@@ -221,6 +970,21 @@ void RunHash(LEDStrip& strip, const char* algo_name,
            35.0 / ((millis() - ts) / 1000.0) * delay_time,
            35.0 / (total_time / total_count) * delay_time);
 
+    for (size_t p = 0; p < HASH_PHASES; ++p) {
+        const HashStats& s = g_hash_stats[p];
+        if (s.operations == 0)
+            continue;
+        printf("%s %s: %zu ops, per op %.2f probes, %.2f cache lines, "
+               "%.2f comparisons, max %zu probes\n",
+               algo_name, HashPhaseName(HashPhase(p)), s.operations,
+               s.probes / double(s.operations),
+               s.cache_lines / double(s.operations),
+               s.comparisons / double(s.operations), s.max_probes);
+    }
+
+    if (HashStatsHook)
+        HashStatsHook(algo_name, array_size);
+
     // printf("%s running time: %.2f\n", algo_name, (millis() - ts) / 1000.0);
 }
 
@@ -0,0 +1,322 @@
+/*******************************************************************************
+ * lib/BlinkenAlgorithms/BlinkenAlgorithms/Animation/LawaPortfolio.hpp
+ *
+ * Portfolio of independent Lawa local searches on worker threads, showing the
+ * best assignment found so far on the strip.
+ *
+ * Copyright (C) 2018 Timo Bingmann <tb@panthema.net>
+ *
+ * All rights reserved. Published under the GNU General Public License v3.0
+ ******************************************************************************/
+
+#ifndef BLINKENALGORITHMS_ANIMATION_LAWAPORTFOLIO_HEADER
+#define BLINKENALGORITHMS_ANIMATION_LAWAPORTFOLIO_HEADER
+
+#include <BlinkenAlgorithms/Animation/LawaSAT.hpp>
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace BlinkenLawaSAT {
+
+/*!
+ * Runs one Lawa search per worker thread on a shared formula, each with its
+ * own seed and noise setting, until one finds a solution or all used up their
+ * flips. Each solver owns its random generator and search state, only the
+ * formula is shared read-only.
+ *
+ * Whenever a worker reaches fewer unsatisfied clauses than all before, it
+ * projects its assignment onto the pixels of a LawaLayout and publishes them
+ * through a sequence lock: writers never wait, they skip publishing while
+ * another worker writes, and readers retry if the snapshot changed while
+ * they copied it. Records are published at most at the frame rate; a record
+ * held back stays pending in its worker until a later chunk boundary or the
+ * end of the search, unless a better one was published meanwhile.
+ */
+class LawaPortfolio
+{
+public:
+    using Solver = LawaT<ItemT<NullInstrumentation> >;
+
+    //! rounds of search between checks for a solution or stop
+    static const unsigned long chunk_rounds = 4096;
+
+    //! the formula must outlive the portfolio
+    LawaPortfolio(const LawaFormula& formula,
+                  size_t threads = std::thread::hardware_concurrency(),
+                  uint32_t seed = rand())
+        : workers_(std::max<size_t>(threads, 1)) {
+        for (size_t w = 0; w < workers_.size(); ++w) {
+            Worker& wk = workers_[w];
+            wk.solver.reset(new Solver(LAWA_INCREMENTAL));
+            wk.solver->shareFormula(formula);
+            wk.solver->seed(seed + 0x9E3779B9u * w);
+            // vary the noise: 0%, 5%, 10% and 15% random walk steps
+            wk.solver->set_noise((w % 4) * 5);
+        }
+    }
+
+    ~LawaPortfolio() {
+        stop();
+        join();
+    }
+
+    //! publish snapshots for a strip of size pixels
+    void set_layout(size_t size, const LawaProjection& projection) {
+        layout_.projection = projection;
+        const LawaFormula& f = workers_[0].solver->formula();
+        layout_.init(size, f.numVariables, f.numClauses);
+        pixels_.reset(new std::atomic<uint32_t>[size]);
+        pixels_size_ = size;
+        for (size_t i = 0; i < size; ++i)
+            pixels_[i].store(Color(0).v, std::memory_order_relaxed);
+    }
+
+    //! start the workers, each flipping at most max_flips literals
+    void start(unsigned long max_flips = -1) {
+        stop_ = false;
+        winner_ = -1;
+        best_unsat_ = size_t(-1);
+        published_unsat_ = size_t(-1);
+        running_ = workers_.size();
+        for (size_t w = 0; w < workers_.size(); ++w) {
+            workers_[w].thread = std::thread(
+                [this, w, max_flips]() { work(w, max_flips); });
+        }
+    }
+
+    //! ask all workers to stop after their current chunk
+    void stop() { stop_ = true; }
+
+    //! wait for all workers
+    void join() {
+        for (Worker& wk : workers_) {
+            if (wk.thread.joinable())
+                wk.thread.join();
+        }
+    }
+
+    //! true while any worker searches
+    bool running() const { return running_.load() != 0; }
+
+    /*!
+     * Copy the latest published snapshot into pixels, which must hold the
+     * layout's strip size. Returns the number of unsatisfied clauses of the
+     * snapshot, or size_t(-1) if nothing was published yet.
+     */
+    size_t snapshot(Color* pixels) const {
+        while (true) {
+            uint32_t seq = seq_.load(std::memory_order_acquire);
+            if (seq & 1) {
+                std::this_thread::yield();
+                continue;
+            }
+            for (size_t i = 0; i < pixels_size_; ++i)
+                pixels[i].v = pixels_[i].load(std::memory_order_relaxed);
+            size_t unsat = published_unsat_.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (seq_.load(std::memory_order_relaxed) == seq)
+                return unsat;
+        }
+    }
+
+    //! fewest unsatisfied clauses reached by any worker
+    size_t best_unsat() const { return best_unsat_.load(); }
+
+    //! index of the worker which found a solution, or -1
+    int winner() const { return winner_.load(); }
+
+    size_t threads() const { return workers_.size(); }
+
+    //! solver of worker w, only to be inspected after join()
+    const Solver& solver(size_t w) const { return *workers_[w].solver; }
+
+    //! flips of all workers, only valid after join()
+    unsigned long flips() const {
+        unsigned long sum = 0;
+        for (const Worker& wk : workers_)
+            sum += wk.solver->num_flips();
+        return sum;
+    }
+
+    unsigned intensity_low = 64;
+
+private:
+    struct Worker {
+        std::unique_ptr<Solver> solver;
+        std::thread thread;
+        //! projected pixels, and number of true variables per pixel
+        std::vector<Color> pixels;
+        std::vector<uint32_t> count, total;
+        //! unsat count of the pixels not yet published, or size_t(-1)
+        size_t pending = size_t(-1);
+    };
+
+    std::vector<Worker> workers_;
+
+    std::atomic<bool> stop_ { false };
+    std::atomic<int> winner_ { -1 };
+    std::atomic<size_t> best_unsat_ { size_t(-1) };
+    std::atomic<size_t> running_ { 0 };
+
+    LawaLayout layout_;
+
+    //! snapshot: odd seq_ while a worker writes pixels_
+    std::atomic<uint32_t> seq_ { 0 };
+    std::unique_ptr<std::atomic<uint32_t>[]> pixels_;
+    size_t pixels_size_ = 0;
+    std::atomic<size_t> published_unsat_ { size_t(-1) };
+    std::atomic<unsigned long> last_publish_ { 0 };
+
+    void work(size_t w, unsigned long max_flips) {
+        Solver& s = *workers_[w].solver;
+        s.makeOccurrenceLists();
+        s.initializeSearch();
+
+        while (!stop_.load(std::memory_order_relaxed) && !g_terminate) {
+            size_t unsat = s.search(chunk_rounds);
+            record(w, unsat);
+            if (unsat == 0) {
+                int none = -1;
+                winner_.compare_exchange_strong(none, int(w));
+                stop_ = true;
+            }
+            if (s.num_flips() >= max_flips)
+                break;
+        }
+        // the final snapshot must show the best record
+        if (workers_[w].pending != size_t(-1))
+            publish(workers_[w], workers_[w].pending, /* force */ true);
+        --running_;
+    }
+
+    //! update the best unsat count, project new records and publish them
+    void record(size_t w, size_t unsat) {
+        Worker& wk = workers_[w];
+        size_t best = best_unsat_.load(std::memory_order_relaxed);
+        while (unsat < best &&
+               !best_unsat_.compare_exchange_weak(best, unsat)) { }
+        if (pixels_size_ == 0)
+            return;
+        if (unsat < best) {
+            project(wk);
+            wk.pending = unsat;
+        }
+        if (wk.pending == size_t(-1))
+            return;
+
+        // show records at the frame rate, but always the solution
+        unsigned long now = micros();
+        unsigned long period = 1000000 / layout_.projection.fps;
+        if (wk.pending != 0 &&
+            now - last_publish_.load(std::memory_order_relaxed) < period)
+            return;
+
+        if (publish(wk, wk.pending, /* force */ wk.pending == 0)) {
+            last_publish_.store(now, std::memory_order_relaxed);
+            wk.pending = size_t(-1);
+        }
+    }
+
+    //! project the assignment of a worker onto its pixels: variables by the
+    //! fraction that is true, clauses red if any is unsatisfied
+    void project(Worker& wk) {
+        const Solver& s = *wk.solver;
+        wk.pixels.assign(pixels_size_, Color(0));
+        wk.count.assign(pixels_size_, 0);
+        wk.total.assign(pixels_size_, 0);
+
+        const auto* vars = s.variable_items();
+        for (size_t i = 0; i < layout_.num_vars; ++i) {
+            size_t p = layout_.var_pixel(i);
+            wk.count[p] += (vars[i].value_ != 0);
+            wk.total[p]++;
+        }
+        for (size_t p = 0; p < layout_.var_pixels; ++p) {
+            if (wk.total[p] != 0)
+                wk.pixels[p] = Color(intensity_low * wk.count[p] / wk.total[p]);
+        }
+
+        const auto* clauses = s.clause_items();
+        for (size_t i = 0; i < layout_.num_clauses; ++i) {
+            size_t p = layout_.clause_pixel(i);
+            if (clauses[i].value_ == 0)
+                wk.pixels[p] = Color(255, 0, 0);
+            else if (wk.pixels[p].v != Color(255, 0, 0).v)
+                wk.pixels[p] = Color(0, 32, 0);
+        }
+    }
+
+    //! copy the worker's pixels into the snapshot if they beat the published
+    //! ones. Returns false without waiting if another worker is writing,
+    //! unless forced.
+    bool publish(const Worker& wk, size_t unsat, bool force) {
+        uint32_t seq = seq_.load(std::memory_order_relaxed);
+        while (true) {
+            if ((seq & 1) == 0 &&
+                seq_.compare_exchange_weak(seq, seq + 1,
+                                           std::memory_order_acq_rel))
+                break;
+            if (!force)
+                return false;
+            seq = seq_.load(std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_release);
+
+        if (unsat < published_unsat_.load(std::memory_order_relaxed)) {
+            for (size_t i = 0; i < pixels_size_; ++i)
+                pixels_[i].store(wk.pixels[i].v, std::memory_order_relaxed);
+            published_unsat_.store(unsat, std::memory_order_relaxed);
+        }
+
+        seq_.store(seq + 2, std::memory_order_release);
+        return true;
+    }
+};
+
+/*!
+ * Solve a formula with a portfolio of threads Lawa searches, showing the best
+ * assignment on the strip at the projection's frame rate. Returns the fewest
+ * unsatisfied clauses reached, zero if solved.
+ */
+template <typename LEDStrip>
+size_t RunLawaPortfolio(LEDStrip& strip, const LawaFormula& formula,
+                        size_t threads, unsigned long max_flips = -1,
+                        const LawaProjection& projection = LawaProjection()) {
+    if (AlgorithmNameHook)
+        AlgorithmNameHook("SAT Solver\nPortfolio");
+
+    LawaPortfolio portfolio(formula, threads, rand());
+    portfolio.set_layout(strip.size(), projection);
+    portfolio.start(max_flips);
+
+    std::vector<Color> pixels(strip.size());
+    auto show = [&]() {
+        if (portfolio.snapshot(pixels.data()) == size_t(-1))
+            return;
+        for (size_t i = 0; i < pixels.size(); ++i)
+            strip.setPixel(i, pixels[i]);
+        strip.show();
+    };
+
+    while (portfolio.running()) {
+        show();
+        delay_micros(1000000 / projection.fps);
+        if (DelayHook)
+            DelayHook();
+        if (g_terminate)
+            portfolio.stop();
+    }
+    portfolio.join();
+    show();
+
+    return portfolio.best_unsat();
+}
+
+} // namespace BlinkenLawaSAT
+
+#endif // !BLINKENALGORITHMS_ANIMATION_LAWAPORTFOLIO_HEADER
+
+/******************************************************************************/
@@ -16,6 +16,11 @@
 #include <BlinkenAlgorithms/Animation/Sort.hpp>
 #include <BlinkenAlgorithms/Color.hpp>
 
+#if !ESP8266 && !TEENSYDUINO
+#include <BlinkenAlgorithms/Extra/MappedFile.hpp>
+#endif
+
+#include <algorithm>
 #include <cmath>
 #include <cstdlib>
 #include <ctype.h>
@@ -25,37 +30,122 @@
 namespace BlinkenLawaSAT {
 
 using namespace BlinkenSort;
+using BlinkenAlgorithms::micros;
+
+//! How Lawa keeps track of make and break scores and unsatisfied clauses.
+enum LawaMode {
+    //! walk per-variable occurrence lists to compute scores on demand, and
+    //! remove satisfied clauses lazily from the unsat list.
+    LAWA_CLASSIC,
+    //! keep break counts up to date in flipLiteral, store all occurrences in
+    //! one contiguous array indexed by literal (CSR) for make scores, and
+    //! keep the exact unsat set with O(1) indexed removal.
+    LAWA_INCREMENTAL
+};
 
-class Lawa
+//! Clauses of a CNF formula, which may be shared by several solvers. The
+//! literals of clause ci are clauseLits[clauseStart[ci], clauseStart[ci+1]).
+struct LawaFormula {
+    int numVariables = 0;
+    int numClauses = 0;
+    std::vector<int> clauseStart;
+    std::vector<int> clauseLits;
+};
+
+template <typename ItemType = Item>
+class LawaT
 {
+public:
+    using value_type = typename ItemType::value_type;
+
+    //! the random generator is seeded from rand()
+    explicit LawaT(LawaMode mode = LAWA_CLASSIC)
+        : mode_(mode), rng_(rand()) { }
+
+    //! non-copyable: may point to its own formula
+    LawaT(const LawaT&) = delete;
+    LawaT& operator = (const LawaT&) = delete;
+
 private:
-    int numVariables;
-    int numClauses;
-    Item* tValues = array.data() - 1;
-    Item* satLits = array.data() + 80;
-
-    struct Clause {
-        int numLits;
-        int8_t lits[3];
-    };
+    LawaMode mode_;
+
+    //! random generator of this solver, such that solvers on different threads
+    //! neither share state nor lock
+    std::minstd_rand rng_;
 
-    Clause* clauses;
+    //! percent of rounds flipping a random literal of the clause
+    unsigned noise_ = 0;
 
-    std::vector<int>* posOccList;
-    std::vector<int>* negOccList;
+    int numVariables = 0;
+    int numClauses = 0;
+
+    //! formula being solved, usually own_
+    LawaFormula own_;
+    const LawaFormula* fla_ = &own_;
+
+    //! truth value of each variable (1 = true) and number of true literals of
+    //! each clause, shown by LawaAnimation
+    std::vector<ItemType> variableItems;
+    std::vector<ItemType> clauseItems;
+    ItemType* tValues = nullptr;
+    ItemType* satLits = nullptr;
+
+    // LAWA_CLASSIC: occurrence lists per variable
+    std::vector<std::vector<int> > posOccList;
+    std::vector<std::vector<int> > negOccList;
     std::vector<int> unsatClauseIds;
 
+    // LAWA_INCREMENTAL: clause ids containing literal lit are
+    // occList[occStart[litIndex(lit)], occStart[litIndex(lit) + 1])
+    std::vector<int> occStart;
+    std::vector<int> occList;
+    //! number of clauses in which each variable is the only true literal
+    std::vector<int> breakCount;
+
+    struct ClauseState {
+        //! xor of the true variables: the critical variable if only one
+        //! literal is true
+        int trueXor;
+        //! index in unsatClauseIds, or -1 if satisfied
+        int unsatPos;
+    };
+
+    std::vector<ClauseState> clauseState;
+
+    unsigned long numFlips = 0;
+
 public:
-    void printClause(const Clause& cls) {
-        for (int li = 0; li < cls.numLits; li++) {
-            // Serial.printf("%d ", cls.lits[li]);
+    int num_variables() const { return numVariables; }
+    int num_clauses() const { return numClauses; }
+    unsigned long num_flips() const { return numFlips; }
+    const LawaFormula& formula() const { return *fla_; }
+
+    void seed(uint32_t s) { rng_.seed(s); }
+    void set_noise(unsigned percent) { noise_ = percent; }
+
+    //! items holding the truth values of variables 1..numVariables
+    const ItemType* variable_items() const { return variableItems.data(); }
+    //! items holding the number of true literals of each clause
+    const ItemType* clause_items() const { return clauseItems.data(); }
+
+    int numLits(int ci) const {
+        return fla_->clauseStart[ci + 1] - fla_->clauseStart[ci];
+    }
+
+    const int* clauseBegin(int ci) const {
+        return fla_->clauseLits.data() + fla_->clauseStart[ci];
+    }
+
+    void printClause(int ci) {
+        for (int li = 0; li < numLits(ci); li++) {
+            // Serial.printf("%d ", clauseBegin(ci)[li]);
         }
         // Serial.printf("0 \n");
     }
 
     void printModel() {
         for (int var = 1; var <= numVariables; var++) {
-            // Serial.printf("%d ", tValues[var].value_);
+            // Serial.printf("%d ", tValues[var].value_ ? var : -var);
         }
         // Serial.printf("\n");
     }
@@ -63,38 +153,76 @@ public:
     void printDebug() {
         for (int ci = 0; ci < numClauses; ci++) {
             // Serial.printf("%d: ", ci);
-            printClause(clauses[ci]);
+            printClause(ci);
         }
         printModel();
     }
 
-    bool is_true(int lit) { return tValues[abs(lit)].value_ == lit; }
+    bool is_true(int lit) {
+        return tValues[abs(lit)].value_ == (lit > 0 ? 1 : 0);
+    }
+
+    static int litIndex(int lit) { return 2 * abs(lit) + (lit < 0 ? 1 : 0); }
 
-    void initializeSearch() {
-        // tValues = new int[numVariables + 1];
-        // satLits = new char[numClauses];
+    void unsatAdd(int cid) {
+        clauseState[cid].unsatPos = unsatClauseIds.size();
+        unsatClauseIds.push_back(cid);
+    }
+
+    void unsatRemove(int cid) {
+        int pos = clauseState[cid].unsatPos;
+        int last = unsatClauseIds.back();
+        unsatClauseIds[pos] = last;
+        clauseState[last].unsatPos = pos;
+        unsatClauseIds.pop_back();
+        clauseState[cid].unsatPos = -1;
+    }
 
+    void initializeSearch() {
         for (int var = 1; var <= numVariables; var++) {
-            tValues[var] = Item(rand() % 2 == 0 ? var : -var);
+            tValues[var] = ItemType(rng_() % 2 == 0 ? 1 : 0);
+        }
+
+        unsatClauseIds.clear();
+        if (mode_ == LAWA_INCREMENTAL) {
+            breakCount.assign(1 + numVariables, 0);
+            clauseState.assign(numClauses, ClauseState { 0, -1 });
         }
 
         for (int ci = 0; ci < numClauses; ci++) {
-            Clause& cls = clauses[ci];
-            char slits = 0;
-            for (int li = 0; li < cls.numLits; li++) {
-                int lit = clauses[ci].lits[li];
-                if (is_true(lit))
+            const int* lits = clauseBegin(ci);
+            value_type slits = 0;
+            for (int li = 0; li < numLits(ci); li++) {
+                int lit = lits[li];
+                if (is_true(lit)) {
                     slits++;
+                    if (mode_ == LAWA_INCREMENTAL)
+                        clauseState[ci].trueXor ^= abs(lit);
+                }
+            }
+            if (mode_ == LAWA_INCREMENTAL) {
+                if (slits == 0)
+                    unsatAdd(ci);
+                else if (slits == 1)
+                    breakCount[clauseState[ci].trueXor]++;
             }
-            if (slits == 0) {
+            else if (slits == 0) {
                 unsatClauseIds.push_back(ci);
             }
-            satLits[ci] = Item(slits);
+            satLits[ci] = ItemType(slits);
         }
     }
 
     int computeMakeScore(int lit) {
         int score = 0;
+        if (mode_ == LAWA_INCREMENTAL) {
+            int idx = litIndex(lit);
+            for (int i = occStart[idx]; i < occStart[idx + 1]; i++) {
+                if (satLits[occList[i]].value_ == 0)
+                    score++;
+            }
+            return score;
+        }
         std::vector<int>& occList =
             lit > 0 ? posOccList[lit] : negOccList[-lit];
         for (int cid : occList) {
@@ -117,7 +245,18 @@ public:
         return score;
     }
 
+    //! make minus break score of flipping lit, which must be false
+    int computeScore(int lit) {
+        if (mode_ == LAWA_INCREMENTAL)
+            return computeMakeScore(lit) - breakCount[abs(lit)];
+        return computeMakeScore(lit) -
+               computeBreakScore(lit); // - flippedCount[abs(lit)];
+    }
+
     void flipLiteral(int lit) {
+        if (mode_ == LAWA_INCREMENTAL)
+            return flipLiteralIncremental(lit);
+
         int var = abs(lit);
         std::vector<int>& decOccList =
             lit > 0 ? negOccList[var] : posOccList[var];
@@ -134,41 +273,97 @@ public:
             satLits[cid]++;
         }
 
-        tValues[var] = Item(lit);
+        tValues[var] = ItemType(lit > 0 ? 1 : 0);
+        numFlips++;
     }
 
-    void search() {
+    void flipLiteralIncremental(int lit) {
+        int var = abs(lit);
+
+        // clauses in which lit becomes true
+        int inc = litIndex(lit);
+        for (int i = occStart[inc]; i < occStart[inc + 1]; i++) {
+            int cid = occList[i];
+            value_type before = satLits[cid].value_;
+            satLits[cid]++;
+            ClauseState& cs = clauseState[cid];
+            if (before == 0) {
+                unsatRemove(cid);
+                breakCount[var]++;
+            }
+            else if (before == 1) {
+                breakCount[cs.trueXor]--;
+            }
+            cs.trueXor ^= var;
+        }
+
+        // clauses in which -lit becomes false
+        int dec = litIndex(-lit);
+        for (int i = occStart[dec]; i < occStart[dec + 1]; i++) {
+            int cid = occList[i];
+            satLits[cid]--;
+            ClauseState& cs = clauseState[cid];
+            cs.trueXor ^= var;
+            value_type after = satLits[cid].value_;
+            if (after == 0) {
+                unsatAdd(cid);
+                breakCount[var]--;
+            }
+            else if (after == 1) {
+                breakCount[cs.trueXor]++;
+            }
+        }
+
+        tValues[var] = ItemType(lit > 0 ? 1 : 0);
+        numFlips++;
+    }
+
+    //! Run the local search for at most max_rounds rounds, returns the number
+    //! of unsatisfied clauses.
+    size_t search(unsigned long max_rounds = 50000) {
         unsigned long round = 0;
-        while (unsatClauseIds.size() > 0) {
+        while (unsatClauseIds.size() > 0 && !g_terminate) {
             round++;
-            if (round >= 50000)
+            if (round >= max_rounds)
                 break;
             // Serial.printf("c round %lu, unsat clauses: %lu\n", round,
             // unsatClauseIds.size());
-            int usidid = rand() % unsatClauseIds.size();
+            int usidid = rng_() % unsatClauseIds.size();
             int usid = unsatClauseIds[usidid];
-            unsatClauseIds[usidid] = unsatClauseIds.back();
-            unsatClauseIds.pop_back();
-            Clause& cls = clauses[usid];
-            if (satLits[usid].value_ > 0) {
-                continue;
+            if (mode_ == LAWA_CLASSIC) {
+                // lazy removal: the clause may have been satisfied since
+                unsatClauseIds[usidid] = unsatClauseIds.back();
+                unsatClauseIds.pop_back();
+                if (satLits[usid].value_ > 0) {
+                    continue;
+                }
             }
+            const int* lits = clauseBegin(usid);
+            int n = numLits(usid);
             // Serial.printf("c will satisfy clause ");
-            // printClause(cls);
+            // printClause(usid);
+
+            if (n == 1) {
+                flipLiteral(lits[0]);
+                continue;
+            }
+            if (noise_ != 0 && rng_() % 100 < noise_) {
+                // random walk step
+                flipLiteral(lits[rng_() % n]);
+                continue;
+            }
 
-            int id1 = rand() % cls.numLits;
-            int id2 = rand() % cls.numLits;
+            int id1 = rng_() % n;
+            int id2 = rng_() % n;
             while (id1 == id2) {
-                id1 = rand() % cls.numLits;
-                id2 = rand() % cls.numLits;
+                id1 = rng_() % n;
+                id2 = rng_() % n;
             }
-            int lit1 = cls.lits[id1];
-            int lit2 = cls.lits[id2];
+            int lit1 = lits[id1];
+            int lit2 = lits[id2];
 
-            int score1 = computeMakeScore(lit1) -
-                         computeBreakScore(lit1); // - flippedCount[abs(lit1)];
-            int score2 = computeMakeScore(lit2) -
-                         computeBreakScore(lit2); // - flippedCount[abs(lit2)];
+            int score1 = computeScore(lit1);
+            int score2 = computeScore(lit2);
 
             if (score1 == score2) {
                 // Serial.printf("c flipping %d and %d, their score: %d\n",
@@ -184,22 +379,48 @@ public:
             }
         }
 
+        size_t unsatCount = numUnsat();
+
+        // Serial.printf("c searched finished after %lu rounds unsats %u.\n",
+        //               round, unsatCount);
+        return unsatCount;
+    }
+
+    //! number of unsatisfied clauses, O(1) in LAWA_INCREMENTAL mode
+    size_t numUnsat() {
+        if (mode_ == LAWA_INCREMENTAL)
+            return unsatClauseIds.size();
         size_t unsatCount = 0;
         for (int i = 0; i < numClauses; ++i) {
             if (satLits[i].value_ == 0)
                 ++unsatCount;
         }
+        return unsatCount;
+    }
 
-        // Serial.printf("c searched finished after %lu rounds unsats %u.\n",
-        //               round, unsatCount);
+    //! Evaluate all clauses from scratch, returns the number of unsatisfied
+    //! clauses.
+    size_t countUnsat() {
+        size_t unsatCount = 0;
+        for (int ci = 0; ci < numClauses; ci++) {
+            bool sat = false;
+            for (int li = 0; li < numLits(ci); li++)
+                sat = sat || is_true(clauseBegin(ci)[li]);
+            if (!sat)
+                ++unsatCount;
+        }
+        return unsatCount;
     }
 
     void makeOccurrenceLists() {
-        posOccList = new std::vector<int>[1 + numVariables];
-        negOccList = new std::vector<int>[1 + numVariables];
+        if (mode_ == LAWA_INCREMENTAL)
+            return makeOccurrenceArray();
+
+        posOccList.assign(1 + numVariables, std::vector<int>());
+        negOccList.assign(1 + numVariables, std::vector<int>());
         for (int ci = 0; ci < numClauses; ci++) {
-            for (int li = 0; li < clauses[ci].numLits; li++) {
-                int lit = clauses[ci].lits[li];
+            for (int li = 0; li < numLits(ci); li++) {
+                int lit = clauseBegin(ci)[li];
                 int var = abs(lit);
                 if (lit > 0) {
                     posOccList[var].push_back(ci);
@@ -211,14 +432,67 @@ public:
         }
     }
 
-    void randomFla(int vars) {
+    void makeOccurrenceArray() {
+        // count occurrences of each literal, then prefix sum to offsets
+        occStart.assign(2 * (1 + numVariables) + 1, 0);
+        for (int lit : fla_->clauseLits)
+            occStart[litIndex(lit) + 1]++;
+        for (size_t i = 1; i < occStart.size(); i++)
+            occStart[i] += occStart[i - 1];
+
+        occList.resize(occStart.back());
+        std::vector<int> fill(occStart.begin(), occStart.end() - 1);
+        for (int ci = 0; ci < numClauses; ci++) {
+            for (int li = 0; li < numLits(ci); li++)
+                occList[fill[litIndex(clauseBegin(ci)[li])]++] = ci;
+        }
+    }
+
+    //! start a new formula with vars variables and no clauses
+    void beginFormula(int vars) {
+        clear();
         numVariables = vars;
-        numClauses = int(4.2 * vars);
+        numClauses = 0;
+        own_.clauseStart.assign(1, 0);
+    }
+
+    void addClause(const int* lits, int n) {
+        own_.clauseLits.insert(own_.clauseLits.end(), lits, lits + n);
+        own_.clauseStart.push_back(own_.clauseLits.size());
+        numClauses++;
+    }
+
+    //! allocate the items of variables and clauses
+    void endFormula() {
+        own_.numVariables = numVariables;
+        own_.numClauses = numClauses;
+        allocateItems();
+    }
+
+    //! solve a formula owned by someone else, which must outlive the solver
+    //! or the next clear()
+    void shareFormula(const LawaFormula& formula) {
+        clear();
+        fla_ = &formula;
+        numVariables = formula.numVariables;
+        numClauses = formula.numClauses;
+        allocateItems();
+    }
+
+    void allocateItems() {
+        std::vector<ItemType>(numVariables).swap(variableItems);
+        std::vector<ItemType>(numClauses).swap(clauseItems);
+        tValues = variableItems.data() - 1;
+        satLits = clauseItems.data();
+    }
+
+    void randomFla(int vars) {
+        beginFormula(vars);
+        int numRandom = int(4.2 * vars);
 
-        clauses = new Clause[numClauses];
-        for (int i = 0; i < numClauses; i++) {
-            clauses[i].numLits = 3;
-            // clauses[i].lits = new int[3];
+        own_.clauseLits.reserve(3 * numRandom);
+        own_.clauseStart.reserve(numRandom + 1);
+        for (int i = 0; i < numRandom; i++) {
             int v1 = (1 + (rand() % vars));
             int v2 = (1 + (rand() % vars));
             int v3 = (1 + (rand() % vars));
@@ -226,29 +500,253 @@ public:
                 v2 = (1 + (rand() % vars));
                 v3 = (1 + (rand() % vars));
             }
-            clauses[i].lits[0] = v1 * (rand() % 2 == 0 ? 1 : -1);
-            clauses[i].lits[1] = v2 * (rand() % 2 == 0 ? 1 : -1);
-            clauses[i].lits[2] = v3 * (rand() % 2 == 0 ? 1 : -1);
+            int lits[3] = {
+                v1 * (rand() % 2 == 0 ? 1 : -1),
+                v2 * (rand() % 2 == 0 ? 1 : -1),
+                v3 * (rand() % 2 == 0 ? 1 : -1)
+            };
+            addClause(lits, 3);
+        }
+        endFormula();
+    }
+
+    /*!
+     * Parse a DIMACS CNF formula in place, without copying the text. Repeated
+     * literals are merged and tautological clauses dropped, the variable count
+     * grows to the largest variable seen. Returns false on syntax errors and
+     * on empty clauses, which make the formula trivially unsatisfiable.
+     */
+    bool loadDimacs(const char* data, size_t size) {
+        const char* p = data;
+        const char* end = data + size;
+        std::vector<int> lits;
+
+        beginFormula(0);
+        while (p != end) {
+            char c = *p;
+            if (c == ' ' || c == '\t' || c == '\r' || c == '\n') {
+                ++p;
+            }
+            else if (c == 'c' || c == 'p') {
+                if (c == 'p') {
+                    // problem line "p cnf <variables> <clauses>"
+                    long vars, clauses;
+                    p = skipSpace(p + 1, end);
+                    if (end - p < 3 || p[0] != 'c' || p[1] != 'n' ||
+                        p[2] != 'f')
+                        return failFormula();
+                    p += 3;
+                    if (!parseInt(p, end, vars) ||
+                        !parseInt(p, end, clauses) ||
+                        vars < 0 || clauses < 0)
+                        return failFormula();
+                    numVariables = std::max<long>(numVariables, vars);
+                    // do not trust the header: each clause takes at least
+                    // two bytes, e.g. "1 0"
+                    own_.clauseStart.reserve(
+                        std::min<size_t>(clauses, size / 2) + 1);
+                }
+                // skip to the end of the line
+                while (p != end && *p != '\n')
+                    ++p;
+            }
+            else if (c == '%') {
+                // end marker of SATLIB benchmark files
+                break;
+            }
+            else {
+                long lit;
+                if (!parseInt(p, end, lit))
+                    return failFormula();
+                if (lit != 0) {
+                    lits.push_back(lit);
+                    numVariables = std::max<long>(numVariables, labs(lit));
+                }
+                else if (!addDimacsClause(lits)) {
+                    return failFormula();
+                }
+            }
+        }
+        // accept a missing terminating zero of the last clause
+        if (!lits.empty() && !addDimacsClause(lits))
+            return failFormula();
+
+        endFormula();
+        return true;
+    }
+
+#if !ESP8266 && !TEENSYDUINO
+    //! load a memory-mapped DIMACS CNF file
+    bool loadDimacsFile(const char* path) {
+        BlinkenAlgorithms::MappedFile file(path);
+        if (!file.ok())
+            return false;
+        if (!loadDimacs(reinterpret_cast<const char*>(file.data()),
+                        file.size())) {
+            fprintf(stderr, "LawaSAT: could not parse %s\n", path);
+            return false;
         }
+        return true;
+    }
+#endif
+
+    //! release the formula and all search state
+    void clear() {
+        numVariables = numClauses = 0;
+        tValues = satLits = nullptr;
+        own_ = LawaFormula();
+        fla_ = &own_;
+        std::vector<ItemType>().swap(variableItems);
+        std::vector<ItemType>().swap(clauseItems);
+        std::vector<std::vector<int> >().swap(posOccList);
+        std::vector<std::vector<int> >().swap(negOccList);
+        std::vector<int>().swap(unsatClauseIds);
+        std::vector<int>().swap(occStart);
+        std::vector<int>().swap(occList);
+        std::vector<int>().swap(breakCount);
+        std::vector<ClauseState>().swap(clauseState);
     }
 
-    void Run() {
-        randomFla(80);
+    void Run(int vars = 80) {
+        randomFla(vars);
         makeOccurrenceLists();
         initializeSearch();
         search();
         // Serial.printf("s SATISFIABLE\nv ");
         printModel();
+        clear();
+    }
 
-        delete[] clauses;
-        delete[] posOccList;
-        delete[] negOccList;
-        std::vector<int>().swap(unsatClauseIds);
+private:
+    static const char* skipSpace(const char* p, const char* end) {
+        while (p != end && (*p == ' ' || *p == '\t'))
+            ++p;
+        return p;
+    }
+
+    //! parse a decimal integer after optional blanks, advancing p
+    static bool parseInt(const char*& p, const char* end, long& out) {
+        p = skipSpace(p, end);
+        bool negative = (p != end && *p == '-');
+        if (negative)
+            ++p;
+        if (p == end || *p < '0' || *p > '9')
+            return false;
+        long v = 0;
+        while (p != end && *p >= '0' && *p <= '9') {
+            v = 10 * v + (*p++ - '0');
+            if (v > (1L << 30))
+                return false;
+        }
+        out = negative ? -v : v;
+        return true;
+    }
+
+    //! sort lits by variable, merge repeated literals and drop tautologies
+    bool addDimacsClause(std::vector<int>& lits) {
+        if (lits.empty())
+            return false;
+        std::sort(lits.begin(), lits.end(), [](int a, int b) {
+                      return abs(a) < abs(b) || (abs(a) == abs(b) && a < b);
+                  });
+        size_t n = 1;
+        for (size_t i = 1; i < lits.size(); ++i) {
+            if (lits[i] == lits[n - 1])
+                continue;
+            if (lits[i] == -lits[n - 1]) {
+                // always satisfied
+                lits.clear();
+                return true;
+            }
+            lits[n++] = lits[i];
+        }
+        addClause(lits.data(), n);
+        lits.clear();
+        return true;
+    }
+
+    bool failFormula() {
+        beginFormula(0);
+        endFormula();
+        return false;
     }
 };
 
+using Lawa = LawaT<Item>;
+
 /******************************************************************************/
 
+//! How LawaAnimation lays out formulas with more variables and clauses than
+//! the strip has pixels.
+enum LawaProjectionMode {
+    //! each pixel shows a contiguous block of variables or clauses
+    LAWA_PROJECT_SCALE,
+    //! variable or clause i is shown on pixel i modulo the size of its region
+    LAWA_PROJECT_MODULO
+};
+
+struct LawaProjection {
+    LawaProjectionMode mode = LAWA_PROJECT_SCALE;
+    //! percent of the strip showing variables, the rest shows clauses. 0
+    //! splits proportionally to the number of variables and clauses.
+    unsigned variable_percent = 0;
+    //! frames per second shown while projecting, instead of a delay per access
+    unsigned fps = 50;
+};
+
+//! Pixels of the variables and clauses of a formula: variables first, then
+//! clauses, one pixel each if they fit the strip, else projected.
+struct LawaLayout {
+    LawaProjection projection;
+    size_t num_vars = 0, num_clauses = 0;
+    //! whether the formula is larger than the strip
+    bool projected = false;
+    size_t var_pixels = 0, clause_pixels = 0;
+
+    void init(size_t size, size_t vars, size_t clauses) {
+        num_vars = vars, num_clauses = clauses;
+        projected = (vars + clauses > size);
+        if (!projected) {
+            var_pixels = vars;
+            clause_pixels = clauses;
+            return;
+        }
+        if (projection.variable_percent != 0)
+            var_pixels = size * projection.variable_percent / 100;
+        else
+            var_pixels = size * vars / (vars + clauses);
+        // at least one pixel for each, but not more than items
+        var_pixels = std::min(std::max<size_t>(var_pixels, 1), size - 1);
+        var_pixels = std::min(var_pixels, vars);
+        clause_pixels = std::min(size - var_pixels, clauses);
+    }
+
+    size_t var_pixel(size_t i) const {
+        return project(i, num_vars, var_pixels);
+    }
+
+    size_t clause_pixel(size_t i) const {
+        return var_pixels + project(i, num_clauses, clause_pixels);
+    }
+
+    //! pixel of item i of count items in a region of pixels
+    size_t project(size_t i, size_t count, size_t pixels) const {
+        if (!projected)
+            return i;
+        if (projection.mode == LAWA_PROJECT_MODULO)
+            return i % pixels;
+        return static_cast<uint64_t>(i) * pixels / count;
+    }
+};
+
+/*!
+ * Shows the variables of a Lawa solver as white (true) or dark (false) pixels
+ * followed by its clauses as red (unsatisfied) or green pixels. If the formula
+ * fits the strip, each access is flashed with a short delay. Otherwise, the
+ * variables and clauses are projected onto their regions of the strip, each
+ * pixel showing the last accessed of its items, and frames are shown at a
+ * fixed rate, such that the solver runs at full speed.
+ */
 template <typename LEDStrip>
 class LawaAnimation : public SortAnimation<LEDStrip>
 {
@@ -256,51 +754,75 @@ public:
     using Super = SortAnimation<LEDStrip>;
     using Super::strip_;
 
-    LawaAnimation(LEDStrip& strip) : Super(strip) { }
+    LawaAnimation(LEDStrip& strip,
+                  const LawaProjection& projection = LawaProjection())
+        : Super(strip) {
+        layout_.projection = projection;
+    }
 
     unsigned intensity_high = 255;
     unsigned intensity_low = 64;
 
-    void OnAccess(const Item* a, bool with_delay) override {
-        if (a < array.data() || a >= array.data() + array_size)
-            return;
-        flash(a - array.data(), with_delay);
+    //! show the variables and clauses of a solver
+    template <typename Solver>
+    void attach(const Solver& lawa) {
+        attach(lawa.variable_items(), lawa.num_variables(),
+               lawa.clause_items(), lawa.num_clauses());
     }
 
-    void flash_low(size_t i) {
-        if (i < 80) {
-            // variables: >= black are negative values.
-            if (array[i].value_ >= unsigned_negative)
-                strip_.setPixel(i, Color(0));
-            else
-                strip_.setPixel(i, Color(intensity_low));
+    void attach(const Item* vars, size_t num_vars,
+                const Item* clauses, size_t num_clauses) {
+        vars_ = vars, clauses_ = clauses;
+        layout_.init(strip_.size(), num_vars, num_clauses);
+
+        for (size_t i = 0; i < strip_.size(); ++i)
+            strip_.setPixel(i, Color(0));
+        access_count_ = 0;
+        last_show_ = micros();
+    }
+
+    void OnAccess(const Item* a, bool with_delay) override {
+        if (a >= vars_ && a < vars_ + layout_.num_vars) {
+            size_t p = layout_.var_pixel(a - vars_);
+            strip_.setPixel(p, a->value_ ? Color(intensity_low) : Color(0));
+            flash(with_delay);
         }
-        else {
-            // clauses
-            if (array[i].value_ == 0) {
-                strip_.setPixel(i, Color(255, 0, 0));
+        else if (a >= clauses_ && a < clauses_ + layout_.num_clauses) {
+            size_t p = layout_.clause_pixel(a - clauses_);
+            if (a->value_ == 0) {
+                strip_.setPixel(p, Color(255, 0, 0));
             }
-            // else if (array[i].value_ == 1) {
-            //     strip_.setPixel(i, Color(96, 96, 0));
+            // else if (a->value_ == 1) {
+            //     strip_.setPixel(p, Color(96, 96, 0));
             // }
-            // else if (array[i].value_ == 2) {
-            //     strip_.setPixel(i, Color(0, 128, 0));
+            // else if (a->value_ == 2) {
+            //     strip_.setPixel(p, Color(0, 128, 0));
             // }
             else {
-                strip_.setPixel(i, Color(0, 32, 0));
+                strip_.setPixel(p, Color(0, 32, 0));
             }
+            flash(with_delay);
         }
     }
 
-    void flash_high(size_t i) {
-        flash_low(i);
-    }
-
-    void flash(size_t i, bool with_delay = true) {
+    void flash(bool with_delay = true) {
         if (!with_delay)
-            return flash_low(i);
+            return;
 
-        flash_high(i);
+        if (layout_.projected) {
+            // check the clock only every few accesses
+            if (++access_count_ % 256 != 0)
+                return;
+            unsigned long now = micros();
+            if (now - last_show_ < 1000000 / layout_.projection.fps ||
+                strip_.busy())
+                return;
+            last_show_ = now;
+            strip_.show();
+            if (DelayHook)
+                DelayHook();
+            return;
+        }
 
         if (!strip_.busy())
             strip_.show();
@@ -308,22 +830,45 @@ public:
         delay_micros(100);
         if (DelayHook)
             DelayHook();
-
-        flash_low(i);
     }
 
     void pflush() {
         strip_.show();
     }
+
+    bool projected() const { return layout_.projected; }
+
+private:
+    LawaLayout layout_;
+
+    const Item* vars_ = nullptr;
+    const Item* clauses_ = nullptr;
+
+    size_t access_count_ = 0;
+    unsigned long last_show_ = 0;
 };
 
+//! solve a loaded formula, showing it on the strip
+template <typename LEDStrip>
+size_t RunLawaSAT(LEDStrip& strip, Lawa& lawa,
+                  unsigned long max_rounds = 50000,
+                  const LawaProjection& projection = LawaProjection()) {
+    LawaAnimation<LEDStrip> ani(strip, projection);
+    ani.attach(lawa);
+    lawa.makeOccurrenceLists();
+    lawa.initializeSearch();
+    size_t unsat = lawa.search(max_rounds);
+    ani.pflush();
+    return unsat;
+}
+
 template <typename LEDStrip>
 void RunLawaSAT(LEDStrip& strip) {
-    LawaAnimation<LEDStrip> ani(strip);
     if (AlgorithmNameHook)
         AlgorithmNameHook("SAT Solver\nLazy Walk");
-    ani.array_black();
-    Lawa().Run();
+    Lawa lawa;
+    lawa.randomFla(80);
+    RunLawaSAT(strip, lawa);
 }
 
 } // namespace BlinkenLawaSAT
@@ -0,0 +1,530 @@
+/*******************************************************************************
+ * lib/BlinkenAlgorithms/BlinkenAlgorithms/Animation/ParallelSort.hpp
+ *
+ * Multithreaded sorting algorithms running on a pool of worker threads, and an
+ * animation which shows the accesses of each worker in its own color.
+ *
+ * Copyright (C) 2018 Timo Bingmann <tb@panthema.net>
+ *
+ * All rights reserved. Published under the GNU General Public License v3.0
+ ******************************************************************************/
+
+#ifndef BLINKENALGORITHMS_ANIMATION_PARALLELSORT_HEADER
+#define BLINKENALGORITHMS_ANIMATION_PARALLELSORT_HEADER
+
+#include <BlinkenAlgorithms/Animation/Sort.hpp>
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace BlinkenSort {
+
+//! number of the sort worker on this thread, 0 for the thread starting a sort
+BLINKEN_THREAD_LOCAL size_t sort_worker_id = 0;
+
+//! smallest range split into parallel tasks
+static const size_t s_parallel_grain = 32;
+
+/******************************************************************************/
+// Worker Pool
+
+/*!
+ * Fixed pool of threads running tasks from a queue. The thread starting a
+ * sort counts as one of the threads: while waiting for its tasks it runs
+ * queued tasks itself, hence nested fork-join never deadlocks.
+ */
+class SortWorkerPool
+{
+public:
+    //! pool of threads threads, including the calling thread
+    explicit SortWorkerPool(
+        size_t threads = std::thread::hardware_concurrency()) {
+        resize(threads);
+    }
+
+    ~SortWorkerPool() {
+        resize(1);
+    }
+
+    //! number of threads including the calling thread
+    size_t threads() const { return workers_.size() + 1; }
+
+    //! stop all workers and start threads - 1 new ones
+    void resize(size_t threads) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        cv_.notify_all();
+        for (std::thread& t : workers_)
+            t.join();
+        workers_.clear();
+
+        stop_ = false;
+        for (size_t w = 1; w < std::max<size_t>(threads, 1); ++w)
+            workers_.emplace_back([this, w]() { work(w); });
+    }
+
+    //! queue a task, pending is incremented now and decremented when done
+    void enqueue(size_t& pending, std::function<void()> task) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            ++pending;
+            queue_.emplace_back(Task { &pending, std::move(task) });
+        }
+        cv_.notify_one();
+    }
+
+    //! run queued tasks until pending drops to zero
+    void wait(size_t& pending) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (pending != 0) {
+            if (queue_.empty())
+                cv_.wait(lock);
+            else
+                run_front(lock);
+        }
+    }
+
+private:
+    struct Task {
+        size_t* pending;
+        std::function<void()> func;
+    };
+
+    std::vector<std::thread> workers_;
+    std::deque<Task> queue_;
+
+    //! protects the queue and the pending counters of task groups
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool stop_ = false;
+
+    void work(size_t worker_id) {
+        sort_worker_id = worker_id;
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!stop_) {
+            if (queue_.empty())
+                cv_.wait(lock);
+            else
+                run_front(lock);
+        }
+    }
+
+    //! run the first task with the lock released
+    void run_front(std::unique_lock<std::mutex>& lock) {
+        Task task = std::move(queue_.front());
+        queue_.pop_front();
+        lock.unlock();
+        task.func();
+        lock.lock();
+        // wake waiting threads, which check their pending counters
+        if (--*task.pending == 0)
+            cv_.notify_all();
+    }
+};
+
+//! pool used by the parallel sorting algorithms
+SortWorkerPool& ParallelSortPool() {
+    static SortWorkerPool pool;
+    return pool;
+}
+
+/*!
+ * Fork-join group of tasks on the ParallelSortPool. Tasks run with the
+ * animation hook and array_size of the thread which created the group, such
+ * that all workers report to the same animation.
+ */
+template <typename ItemType>
+class SortTaskGroup
+{
+public:
+    SortTaskGroup()
+        : pool_(ParallelSortPool()),
+          hook_(SortAnimationBaseT<ItemType>::hook), size_(array_size) { }
+
+    ~SortTaskGroup() { wait(); }
+
+    template <typename Function>
+    void spawn(Function func) {
+        SortAnimationBaseT<ItemType>* hook = hook_;
+        size_t size = size_;
+        pool_.enqueue(
+            pending_, [hook, size, func]() {
+                SortAnimationBaseT<ItemType>*& h =
+                    SortAnimationBaseT<ItemType>::hook;
+                SortAnimationBaseT<ItemType>* saved_hook = h;
+                size_t saved_size = array_size;
+                h = hook, array_size = size;
+                func();
+                h = saved_hook, array_size = saved_size;
+            });
+    }
+
+    void wait() { pool_.wait(pending_); }
+
+private:
+    SortWorkerPool& pool_;
+    SortAnimationBaseT<ItemType>* hook_;
+    size_t size_;
+    size_t pending_ = 0;
+};
+
+/******************************************************************************/
+// Parallel Merge Sort: sort both halves in parallel, then merge sequentially
+
+template <typename Item>
+void ParallelMergeSort(Item* A, size_t lo, size_t hi, size_t depth) {
+    if (g_terminate)
+        return;
+
+    if (depth == 0 || hi - lo < s_parallel_grain)
+        return MergeSort(A, lo, hi);
+
+    size_t mid = (lo + hi) / 2;
+    {
+        SortTaskGroup<Item> group;
+        group.spawn([=]() { ParallelMergeSort(A, lo, mid, depth - 1); });
+        ParallelMergeSort(A, mid, hi, depth - 1);
+    }
+    Merge(A, lo, mid, hi);
+}
+
+template <typename Item>
+void ParallelMergeSort(Item* A, size_t n) {
+    // about four tasks per thread
+    size_t depth = 2;
+    while ((size_t(1) << depth) < ParallelSortPool().threads())
+        ++depth;
+    ParallelMergeSort(A, 0, n, depth);
+}
+
+/******************************************************************************/
+// Parallel Quick Sort: Hoare partition around the middle item, then sort the
+// left part in a new task and the right part on this thread.
+
+template <typename Item>
+void ParallelQuickSort(Item* A, ssize_t lo, ssize_t hi,
+                       SortTaskGroup<Item>& group) {
+    while (lo < hi && !g_terminate) {
+        if (hi - lo < static_cast<ssize_t>(s_parallel_grain))
+            return QuickSortLR(A, lo, hi);
+
+        ssize_t p = (lo + hi) / 2;
+        ssize_t i = lo, j = hi;
+
+        while (i <= j && !g_terminate) {
+            while (A[i] < A[p])
+                i++;
+            while (A[j] > A[p])
+                j--;
+            if (i <= j) {
+                swap(A[i], A[j]);
+                // follow pivot if it is swapped
+                p = (p == i ? j : p == j ? i : p);
+                i++, j--;
+            }
+        }
+
+        if (lo < j) {
+            group.spawn([A, lo, j, &group]() {
+                            ParallelQuickSort(A, lo, j, group);
+                        });
+        }
+        lo = i;
+    }
+}
+
+template <typename Item>
+void ParallelQuickSort(Item* A, size_t n) {
+    SortTaskGroup<Item> group;
+    ParallelQuickSort(A, 0, static_cast<ssize_t>(n) - 1, group);
+    group.wait();
+}
+
+/******************************************************************************/
+// Bitonic Sort for arbitrary n (after H. W. Lang): the two recursive halves
+// and the compare-exchange loops of large merges run as parallel tasks.
+
+template <typename Item>
+void BitonicCompare(Item* A, size_t i, size_t j, bool up) {
+    if ((A[i] > A[j]) == up)
+        swap(A[i], A[j]);
+}
+
+template <typename Item>
+void BitonicMerge(Item* A, size_t lo, size_t n, bool up) {
+    if (n <= 1 || g_terminate)
+        return;
+
+    // greatest power of two less than n
+    size_t m = 1;
+    while (2 * m < n)
+        m *= 2;
+
+    if (n - m < 2 * s_parallel_grain) {
+        for (size_t i = lo; i < lo + n - m; ++i)
+            BitonicCompare(A, i, i + m, up);
+    }
+    else {
+        SortTaskGroup<Item> group;
+        size_t chunks = std::min(ParallelSortPool().threads(),
+                                 (n - m) / s_parallel_grain);
+        for (size_t c = 0; c < chunks; ++c) {
+            size_t begin = lo + (n - m) * c / chunks;
+            size_t end = lo + (n - m) * (c + 1) / chunks;
+            group.spawn([=]() {
+                            for (size_t i = begin; i < end; ++i)
+                                BitonicCompare(A, i, i + m, up);
+                        });
+        }
+    }
+
+    if (n < 2 * s_parallel_grain) {
+        BitonicMerge(A, lo, m, up);
+        BitonicMerge(A, lo + m, n - m, up);
+    }
+    else {
+        SortTaskGroup<Item> group;
+        group.spawn([=]() { BitonicMerge(A, lo, m, up); });
+        BitonicMerge(A, lo + m, n - m, up);
+    }
+}
+
+template <typename Item>
+void BitonicSort(Item* A, size_t lo, size_t n, bool up) {
+    if (n <= 1 || g_terminate)
+        return;
+
+    size_t m = n / 2;
+    if (n < 2 * s_parallel_grain) {
+        BitonicSort(A, lo, m, !up);
+        BitonicSort(A, lo + m, n - m, up);
+    }
+    else {
+        SortTaskGroup<Item> group;
+        group.spawn([=]() { BitonicSort(A, lo, m, !up); });
+        BitonicSort(A, lo + m, n - m, up);
+    }
+    BitonicMerge(A, lo, n, up);
+}
+
+template <typename Item>
+void BitonicSort(Item* A, size_t n) {
+    BitonicSort(A, 0, n, /* up */ true);
+}
+
+/******************************************************************************/
+// Odd-Even Transposition Sort: n phases compare-exchanging all even or all odd
+// neighbour pairs, each phase split among the threads.
+
+template <typename Item>
+void OddEvenTranspositionSort(Item* A, size_t n) {
+    size_t threads = ParallelSortPool().threads();
+
+    for (size_t phase = 0; phase < n && !g_terminate; ++phase) {
+        size_t pairs = (n - (phase % 2)) / 2;
+        size_t chunks = std::max<size_t>(
+            1, std::min(threads, pairs / s_parallel_grain));
+
+        SortTaskGroup<Item> group;
+        for (size_t c = 0; c < chunks; ++c) {
+            size_t begin = pairs * c / chunks, end = pairs * (c + 1) / chunks;
+            auto compare_pairs = [=]() {
+                                     for (size_t p = begin; p < end; ++p) {
+                                         size_t i = 2 * p + (phase % 2);
+                                         if (A[i + 1] < A[i])
+                                             swap(A[i], A[i + 1]);
+                                     }
+                                 };
+            if (c + 1 < chunks)
+                group.spawn(compare_pairs);
+            else
+                compare_pairs();
+        }
+    }
+}
+
+/******************************************************************************/
+
+/*!
+ * SortAnimation for the parallel algorithms: the callbacks are serialized by a
+ * mutex, and flashed items are drawn in the color of the worker accessing
+ * them. With a positive delay_time each worker sleeps outside the lock, such
+ * that all workers progress concurrently and a frame shows the current item
+ * of every worker. A negative delay_time shows a frame every -delay_time
+ * steps of all workers together. Adaptive pacing is not supported.
+ */
+template <typename LEDStrip, typename ItemType = Item>
+class ParallelSortAnimation : public SortAnimation<LEDStrip, ItemType>
+{
+public:
+    using Super = SortAnimation<LEDStrip, ItemType>;
+
+    ParallelSortAnimation(LEDStrip& strip, size_t workers,
+                          int32_t delay_time = 1000)
+        : Super(strip, delay_time), workers_(std::max<size_t>(workers, 1)) { }
+
+    void OnAccess(const ItemType* a, bool with_delay) override {
+        if (!in_array(a))
+            return;
+        size_t i = a - this->array.data();
+        if (!with_delay) {
+            std::unique_lock<std::mutex> lock(mutex_);
+            return this->flash_low(i);
+        }
+        flash_worker(i, size_t(-1));
+    }
+
+    void IncrementCounter() override {
+        std::unique_lock<std::mutex> lock(mutex_);
+        Super::IncrementCounter();
+    }
+
+    void OnComparison(const ItemType* a, const ItemType* b) override {
+        IncrementCounter();
+        if (in_array(a) && in_array(b))
+            flash_worker(a - this->array.data(), b - this->array.data());
+        else if (in_array(a))
+            flash_worker(a - this->array.data(), size_t(-1));
+        else if (in_array(b))
+            flash_worker(b - this->array.data(), size_t(-1));
+    }
+
+    void set_delay_time(int32_t delay_time) {
+        flush_pending();
+        Super::set_delay_time(delay_time);
+    }
+
+    void pflush() {
+        flush_pending();
+        Super::pflush();
+    }
+
+    //! color of flashed items of a worker
+    Color worker_color(size_t worker) const {
+        uint8_t intensity = this->intensity_high();
+        Color c = HSVColor(
+            (worker % workers_) * HSV_HUE_MAX / workers_, 255, intensity);
+        c.white = intensity;
+        return c;
+    }
+
+protected:
+    //! number of workers to spread the colors over
+    size_t workers_;
+
+    //! serializes all drawing and counting
+    std::mutex mutex_;
+
+    //! steps since the last frame with a frame drop count
+    size_t frame_steps_ = 0;
+
+    bool in_array(const ItemType* a) const {
+        return a >= this->array.data() && a < this->array.data() + array_size;
+    }
+
+    //! flash items i and j (if j != -1) in the color of this thread's worker
+    void flash_worker(size_t i, size_t j) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        ++this->step_count_;
+
+        Color c = worker_color(sort_worker_id);
+        this->strip_.setPixel(i, c);
+        if (j != size_t(-1))
+            this->strip_.setPixel(j, c);
+
+        if (this->frame_drop_ == 0) {
+            if (!this->strip_.busy())
+                this->strip_.show();
+
+            // sleep without blocking the other workers
+            lock.unlock();
+            delay_micros(this->delay_time_ * g_delay_factor / 1000);
+            lock.lock();
+
+            this->flash_low(i);
+            if (j != size_t(-1))
+                this->flash_low(j);
+            return;
+        }
+
+        pending_.push_back(i);
+        if (j != size_t(-1))
+            pending_.push_back(j);
+
+        if (++frame_steps_ < this->frame_drop_)
+            return;
+
+        if (!this->strip_.busy())
+            this->strip_.show();
+        for (size_t k : pending_)
+            this->flash_low(k);
+        pending_.clear();
+        frame_steps_ = 0;
+    }
+
+    //! pixels flashed since the last frame with a frame drop count
+    std::vector<size_t> pending_;
+
+    //! reset pixels flashed since the last frame
+    void flush_pending() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (size_t k : pending_)
+            this->flash_low(k);
+        pending_.clear();
+        frame_steps_ = 0;
+    }
+};
+
+/*!
+ * Run a parallel sort animation on threads worker threads. The sound and
+ * delay hooks are not thread-safe and are disabled while sorting.
+ */
+template <typename LEDStrip, typename ItemType = Item>
+void RunParallelSort(LEDStrip& strip, const char* algo_name,
+                     void (*sort_function)(ItemType* A, size_t n),
+                     size_t threads, int32_t delay_time = 10000) {
+
+    uint32_t ts = millis();
+
+    ParallelSortPool().resize(threads);
+
+    ParallelSortAnimation<LEDStrip, ItemType> ani(
+        strip, ParallelSortPool().threads(), delay_time);
+    if (AlgorithmNameHook)
+        AlgorithmNameHook(algo_name);
+    ani.array_randomize();
+
+    void (* sound_hook)(size_t i) = SoundAccessHook;
+    void (* delay_hook)() = DelayHook;
+    void (* count_hook)(size_t count) = ComparisonCountHook;
+    SoundAccessHook = nullptr, DelayHook = nullptr;
+    ComparisonCountHook = nullptr;
+
+    sort_function(SortArray<ItemType>().data(), array_size);
+
+    SoundAccessHook = sound_hook, DelayHook = delay_hook;
+    ComparisonCountHook = count_hook;
+
+    printf("%s on %zu threads running time: %.2f\n",
+           algo_name, ParallelSortPool().threads(),
+           (millis() - ts) / 1000.0);
+
+    ani.set_delay_time(-4);
+    ani.set_enable_count(false);
+    ani.array_check();
+    ani.pflush();
+    ani.yield_delay(2000000);
+}
+
+} // namespace BlinkenSort
+
+#endif // !BLINKENALGORITHMS_ANIMATION_PARALLELSORT_HEADER
+
+/******************************************************************************/
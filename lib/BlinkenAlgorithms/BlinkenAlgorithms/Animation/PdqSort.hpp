@@ -0,0 +1,518 @@
+/*******************************************************************************
+ * lib/BlinkenAlgorithms/BlinkenAlgorithms/Animation/PdqSort.hpp
+ *
+ * Pattern-defeating quicksort (pdqsort) with the branchless block partitioning
+ * of BlockQuicksort.
+ *
+ * code from https://github.com/orlp/pdqsort
+ *
+ * BlockQuicksort: Edelkamp and Weiss, "BlockQuicksort: How Branch Mispredictions
+ * don't affect Quicksort", ESA 2016.
+ *
+ * See special file license below.
+ ******************************************************************************/
+
+#ifndef BLINKENALGORITHMS_ANIMATION_PDQSORT_HEADER
+#define BLINKENALGORITHMS_ANIMATION_PDQSORT_HEADER
+
+/*
+ * Copyright (c) 2015 Orson Peters <orsonpeters@gmail.com>
+ *
+ * This software is provided 'as-is', without any express or implied warranty.
+ * In no event will the authors be held liable for any damages arising from
+ * the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software in
+ *    a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+/*
+ * Altered for BlinkenAlgorithms: reduced to random access pointers, the
+ * offset buffers are not aligned to cache lines, and the fill loops are not
+ * unrolled.
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <utility>
+
+namespace PdqSortNS {
+
+enum {
+    // Partitions below this size are sorted using insertion sort.
+    insertion_sort_threshold = 24,
+
+    // Partitions above this size use Tukey's ninther to select the pivot.
+    ninther_threshold = 128,
+
+    // When we detect an already sorted partition, attempt an insertion sort
+    // that allows this amount of element moves before giving up.
+    partial_insertion_sort_limit = 8,
+
+    // Size of the offset buffers of the block partitioning, must be < 256 to
+    // fit in unsigned char.
+    block_size = 64
+};
+
+// Returns floor(log2(n)), assumes n > 0.
+template <class T>
+inline int log2(T n) {
+    int log = 0;
+    while (n >>= 1) ++log;
+    return log;
+}
+
+// Sorts [begin, end) using insertion sort with the given comparison function.
+template <class T, class Compare>
+inline void insertion_sort(T* begin, T* end, Compare comp) {
+    if (begin == end) return;
+
+    for (T* cur = begin + 1; cur != end; ++cur) {
+        T* sift = cur;
+        T* sift_1 = cur - 1;
+
+        // Compare first so we can avoid 2 moves for an element already
+        // positioned correctly.
+        if (comp(*sift, *sift_1)) {
+            T tmp = std::move(*sift);
+
+            do { *sift-- = std::move(*sift_1); }
+            while (sift != begin && comp(tmp, *--sift_1));
+
+            *sift = std::move(tmp);
+        }
+    }
+}
+
+// Sorts [begin, end) using insertion sort with the given comparison function.
+// Assumes *(begin - 1) is an element smaller than or equal to any element in
+// [begin, end).
+template <class T, class Compare>
+inline void unguarded_insertion_sort(T* begin, T* end, Compare comp) {
+    if (begin == end) return;
+
+    for (T* cur = begin + 1; cur != end; ++cur) {
+        T* sift = cur;
+        T* sift_1 = cur - 1;
+
+        // Compare first so we can avoid 2 moves for an element already
+        // positioned correctly.
+        if (comp(*sift, *sift_1)) {
+            T tmp = std::move(*sift);
+
+            do { *sift-- = std::move(*sift_1); }
+            while (comp(tmp, *--sift_1));
+
+            *sift = std::move(tmp);
+        }
+    }
+}
+
+// Attempts to use insertion sort on [begin, end). Will return false if more
+// than partial_insertion_sort_limit elements were moved, and abort sorting.
+// Otherwise it will successfully sort and return true.
+template <class T, class Compare>
+inline bool partial_insertion_sort(T* begin, T* end, Compare comp) {
+    if (begin == end) return true;
+
+    std::size_t limit = 0;
+    for (T* cur = begin + 1; cur != end; ++cur) {
+        T* sift = cur;
+        T* sift_1 = cur - 1;
+
+        // Compare first so we can avoid 2 moves for an element already
+        // positioned correctly.
+        if (comp(*sift, *sift_1)) {
+            T tmp = std::move(*sift);
+
+            do { *sift-- = std::move(*sift_1); }
+            while (sift != begin && comp(tmp, *--sift_1));
+
+            *sift = std::move(tmp);
+            limit += cur - sift;
+        }
+
+        if (limit > partial_insertion_sort_limit) return false;
+    }
+
+    return true;
+}
+
+template <class T, class Compare>
+inline void sort2(T* a, T* b, Compare comp) {
+    if (comp(*b, *a)) std::iter_swap(a, b);
+}
+
+// Sorts the elements *a, *b and *c using comparison function comp.
+template <class T, class Compare>
+inline void sort3(T* a, T* b, T* c, Compare comp) {
+    sort2(a, b, comp);
+    sort2(b, c, comp);
+    sort2(a, b, comp);
+}
+
+// Swaps the num elements at first + offsets_l[i] with those at
+// last - offsets_r[i], using a cyclic permutation with one temporary unless
+// use_swaps is set.
+template <class T>
+inline void swap_offsets(T* first, T* last,
+                         unsigned char* offsets_l, unsigned char* offsets_r,
+                         std::size_t num, bool use_swaps) {
+    if (use_swaps) {
+        // This case is needed for the descending distribution, where we need
+        // to have proper swapping for pdqsort to remain O(n).
+        for (std::size_t i = 0; i < num; ++i) {
+            std::iter_swap(first + offsets_l[i], last - offsets_r[i]);
+        }
+    }
+    else if (num > 0) {
+        T* l = first + offsets_l[0];
+        T* r = last - offsets_r[0];
+        T tmp(std::move(*l));
+        *l = std::move(*r);
+        for (std::size_t i = 1; i < num; ++i) {
+            l = first + offsets_l[i];
+            *r = std::move(*l);
+            r = last - offsets_r[i];
+            *l = std::move(*r);
+        }
+        *r = std::move(tmp);
+    }
+}
+
+// Partitions [begin, end) around pivot *begin using comparison function comp.
+// Elements equal to the pivot are put in the right-hand partition. Returns the
+// position of the pivot after partitioning and whether the passed sequence
+// already was correctly partitioned. Assumes the pivot is a median of at least
+// 3 elements and that [begin, end) is at least insertion_sort_threshold long.
+// Uses branchless partitioning: the comparison results are written into offset
+// buffers of block_size elements instead of being branched on.
+template <class T, class Compare>
+inline std::pair<T*, bool>
+partition_right_branchless(T* begin, T* end, Compare comp) {
+    // Move pivot into local for speed.
+    T pivot(std::move(*begin));
+    T* first = begin;
+    T* last = end;
+
+    // Find the first element greater than or equal than the pivot (the median
+    // of 3 guarantees this exists).
+    while (comp(*++first, pivot)) { }
+
+    // Find the first element strictly smaller than the pivot. We have to guard
+    // this search if there was no element before *first.
+    if (first - 1 == begin)
+        while (first < last && !comp(*--last, pivot)) { }
+    else
+        while (!comp(*--last, pivot)) { }
+
+    // If the first pair of elements that should be swapped to partition are
+    // the same element, the passed in sequence already was correctly
+    // partitioned.
+    bool already_partitioned = first >= last;
+    if (!already_partitioned) {
+        std::iter_swap(first, last);
+        ++first;
+
+        // The following branchless partitioning is derived from
+        // "BlockQuicksort: How Branch Mispredictions don't affect Quicksort"
+        // by Stefan Edelkamp and Armin Weiss.
+        unsigned char offsets_l[block_size];
+        unsigned char offsets_r[block_size];
+
+        T* offsets_l_base = first;
+        T* offsets_r_base = last;
+        std::size_t num_l, num_r, start_l, start_r;
+        num_l = num_r = start_l = start_r = 0;
+
+        while (first < last) {
+            // Fill up offset blocks with elements that are on the wrong side.
+            // First we determine how much elements are considered for each
+            // offset block.
+            std::size_t num_unknown = last - first;
+            std::size_t left_split =
+                num_l == 0 ? (num_r == 0 ? num_unknown / 2 : num_unknown) : 0;
+            std::size_t right_split = num_r == 0 ? (num_unknown - left_split) : 0;
+
+            // Fill the offset blocks.
+            if (left_split > block_size) left_split = block_size;
+            for (std::size_t i = 0; i < left_split; ) {
+                offsets_l[num_l] = i++;
+                num_l += !comp(*first, pivot);
+                ++first;
+            }
+
+            if (right_split > block_size) right_split = block_size;
+            for (std::size_t i = 0; i < right_split; ) {
+                offsets_r[num_r] = ++i;
+                num_r += comp(*--last, pivot);
+            }
+
+            // Swap elements and update block sizes and first/last boundaries.
+            std::size_t num = std::min(num_l, num_r);
+            swap_offsets(offsets_l_base, offsets_r_base,
+                         offsets_l + start_l, offsets_r + start_r,
+                         num, num_l == num_r);
+            num_l -= num;
+            num_r -= num;
+            start_l += num;
+            start_r += num;
+
+            if (num_l == 0) {
+                start_l = 0;
+                offsets_l_base = first;
+            }
+
+            if (num_r == 0) {
+                start_r = 0;
+                offsets_r_base = last;
+            }
+        }
+
+        // We have now fully identified [first, last)'s proper position. Swap
+        // the last elements.
+        if (num_l) {
+            unsigned char* offsets = offsets_l + start_l;
+            while (num_l--)
+                std::iter_swap(offsets_l_base + offsets[num_l], --last);
+            first = last;
+        }
+        if (num_r) {
+            unsigned char* offsets = offsets_r + start_r;
+            while (num_r--)
+                std::iter_swap(offsets_r_base - offsets[num_r], first), ++first;
+            last = first;
+        }
+    }
+
+    // Put the pivot in the right place.
+    T* pivot_pos = first - 1;
+    *begin = std::move(*pivot_pos);
+    *pivot_pos = std::move(pivot);
+
+    return std::make_pair(pivot_pos, already_partitioned);
+}
+
+// Partitions [begin, end) around pivot *begin using comparison function comp.
+// Elements equal to the pivot are put in the right-hand partition. Returns the
+// position of the pivot after partitioning and whether the passed sequence
+// already was correctly partitioned. Assumes the pivot is a median of at least
+// 3 elements and that [begin, end) is at least insertion_sort_threshold long.
+template <class T, class Compare>
+inline std::pair<T*, bool> partition_right(T* begin, T* end, Compare comp) {
+    // Move pivot into local for speed.
+    T pivot(std::move(*begin));
+
+    T* first = begin;
+    T* last = end;
+
+    // Find the first element greater than or equal than the pivot (the median
+    // of 3 guarantees this exists).
+    while (comp(*++first, pivot)) { }
+
+    // Find the first element strictly smaller than the pivot. We have to guard
+    // this search if there was no element before *first.
+    if (first - 1 == begin)
+        while (first < last && !comp(*--last, pivot)) { }
+    else
+        while (!comp(*--last, pivot)) { }
+
+    // If the first pair of elements that should be swapped to partition are
+    // the same element, the passed in sequence already was correctly
+    // partitioned.
+    bool already_partitioned = first >= last;
+
+    // Keep swapping pairs of elements that are on the wrong side of the pivot.
+    // Previously swapped pairs guard the searches, which is why the first
+    // iteration is special-cased above.
+    while (first < last) {
+        std::iter_swap(first, last);
+        while (comp(*++first, pivot)) { }
+        while (!comp(*--last, pivot)) { }
+    }
+
+    // Put the pivot in the right place.
+    T* pivot_pos = first - 1;
+    *begin = std::move(*pivot_pos);
+    *pivot_pos = std::move(pivot);
+
+    return std::make_pair(pivot_pos, already_partitioned);
+}
+
+// Similar function to the one above, except elements equal to the pivot are
+// put to the left of the pivot and it doesn't check or return if the passed
+// sequence already was partitioned. Since this is rarely used (the many
+// equal case), and in that case pdqsort already has O(n) performance, no
+// block quicksort is applied here for simplicity.
+template <class T, class Compare>
+inline T* partition_left(T* begin, T* end, Compare comp) {
+    T pivot(std::move(*begin));
+    T* first = begin;
+    T* last = end;
+
+    while (comp(pivot, *--last)) { }
+
+    if (last + 1 == end)
+        while (first < last && !comp(pivot, *++first)) { }
+    else
+        while (!comp(pivot, *++first)) { }
+
+    while (first < last) {
+        std::iter_swap(first, last);
+        while (comp(pivot, *--last)) { }
+        while (!comp(pivot, *++first)) { }
+    }
+
+    T* pivot_pos = last;
+    *begin = std::move(*pivot_pos);
+    *pivot_pos = std::move(pivot);
+
+    return pivot_pos;
+}
+
+template <class T, class Compare, bool Branchless>
+inline void pdqsort_loop(T* begin, T* end, Compare comp, int bad_allowed,
+                         bool leftmost = true) {
+    typedef std::ptrdiff_t diff_t;
+
+    // Use a while loop for tail recursion elimination.
+    while (true) {
+        diff_t size = end - begin;
+
+        // Insertion sort is faster for small arrays.
+        if (size < insertion_sort_threshold) {
+            if (leftmost) insertion_sort(begin, end, comp);
+            else unguarded_insertion_sort(begin, end, comp);
+            return;
+        }
+
+        // Choose pivot as median of 3 or pseudomedian of 9.
+        diff_t s2 = size / 2;
+        if (size > ninther_threshold) {
+            sort3(begin, begin + s2, end - 1, comp);
+            sort3(begin + 1, begin + (s2 - 1), end - 2, comp);
+            sort3(begin + 2, begin + (s2 + 1), end - 3, comp);
+            sort3(begin + (s2 - 1), begin + s2, begin + (s2 + 1), comp);
+            std::iter_swap(begin, begin + s2);
+        }
+        else {
+            sort3(begin + s2, begin, end - 1, comp);
+        }
+
+        // If *(begin - 1) is the end of the right partition of a previous
+        // partition operation there is no element in [begin, end) that is
+        // smaller than *(begin - 1). Then if our pivot compares equal to
+        // *(begin - 1) we change strategy, putting equal elements in the left
+        // partition, greater elements in the right partition. We do not have
+        // to recurse on the left partition, since it's sorted (all equal).
+        if (!leftmost && !comp(*(begin - 1), *begin)) {
+            begin = partition_left(begin, end, comp) + 1;
+            continue;
+        }
+
+        // Partition and get results.
+        std::pair<T*, bool> part_result =
+            Branchless ? partition_right_branchless(begin, end, comp)
+            : partition_right(begin, end, comp);
+        T* pivot_pos = part_result.first;
+        bool already_partitioned = part_result.second;
+
+        // Check for a highly unbalanced partition.
+        diff_t l_size = pivot_pos - begin;
+        diff_t r_size = end - (pivot_pos + 1);
+        bool highly_unbalanced = l_size < size / 8 || r_size < size / 8;
+
+        // If we got a highly unbalanced partition we shuffle elements to break
+        // many patterns.
+        if (highly_unbalanced) {
+            // If we had too many bad partitions, switch to heapsort to
+            // guarantee O(n log n).
+            if (--bad_allowed == 0) {
+                std::make_heap(begin, end, comp);
+                std::sort_heap(begin, end, comp);
+                return;
+            }
+
+            if (l_size >= insertion_sort_threshold) {
+                std::iter_swap(begin, begin + l_size / 4);
+                std::iter_swap(pivot_pos - 1, pivot_pos - l_size / 4);
+
+                if (l_size > ninther_threshold) {
+                    std::iter_swap(begin + 1, begin + (l_size / 4 + 1));
+                    std::iter_swap(begin + 2, begin + (l_size / 4 + 2));
+                    std::iter_swap(pivot_pos - 2, pivot_pos - (l_size / 4 + 1));
+                    std::iter_swap(pivot_pos - 3, pivot_pos - (l_size / 4 + 2));
+                }
+            }
+
+            if (r_size >= insertion_sort_threshold) {
+                std::iter_swap(pivot_pos + 1, pivot_pos + (1 + r_size / 4));
+                std::iter_swap(end - 1, end - r_size / 4);
+
+                if (r_size > ninther_threshold) {
+                    std::iter_swap(pivot_pos + 2, pivot_pos + (2 + r_size / 4));
+                    std::iter_swap(pivot_pos + 3, pivot_pos + (3 + r_size / 4));
+                    std::iter_swap(end - 2, end - (1 + r_size / 4));
+                    std::iter_swap(end - 3, end - (2 + r_size / 4));
+                }
+            }
+        }
+        else {
+            // If we were decently balanced and we tried to sort an already
+            // partitioned sequence try to use insertion sort.
+            if (already_partitioned &&
+                partial_insertion_sort(begin, pivot_pos, comp) &&
+                partial_insertion_sort(pivot_pos + 1, end, comp))
+                return;
+        }
+
+        // Sort the left partition first using recursion and do tail recursion
+        // elimination for the right-hand partition.
+        pdqsort_loop<T, Compare, Branchless>(
+            begin, pivot_pos, comp, bad_allowed, leftmost);
+        begin = pivot_pos + 1;
+        leftmost = false;
+    }
+}
+
+template <class T, class Compare>
+inline void pdqsort(T* begin, T* end, Compare comp) {
+    if (begin == end) return;
+    pdqsort_loop<T, Compare, false>(
+        begin, end, comp, log2(end - begin));
+}
+
+template <class T, class Compare>
+inline void pdqsort_branchless(T* begin, T* end, Compare comp) {
+    if (begin == end) return;
+    pdqsort_loop<T, Compare, true>(
+        begin, end, comp, log2(end - begin));
+}
+
+template <class T>
+inline void pdqsort(T* begin, T* end) {
+    pdqsort(begin, end, std::less<T>());
+}
+
+template <class T>
+inline void pdqsort_branchless(T* begin, T* end) {
+    pdqsort_branchless(begin, end, std::less<T>());
+}
+
+} // namespace PdqSortNS
+
+#endif // !BLINKENALGORITHMS_ANIMATION_PDQSORT_HEADER
+
+/******************************************************************************/
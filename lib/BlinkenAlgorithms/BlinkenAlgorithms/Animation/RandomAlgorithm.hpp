@@ -15,11 +15,15 @@
 
 namespace BlinkenAlgorithms {
 
+//! number of animations cycled through by RunRandomAlgorithmAnimation()
+static const size_t random_algorithm_cycle = 25;
+
 /*!
  * BlinkenAlgorithms with delay time adapted for ESP8266 and Teensy 3.6 such
  * that most algorithms run approximately 15 seconds each for a strip with 300
  * LEDs.  Asymptotically slower algorithms run 20 seconds, faster ones 10 or
- * less.
+ * less. An installed Calibration replaces these delay times, the ESP8266 and
+ * Teensy programs install one from a generated table.
  */
 template <typename LEDStrip>
 void RunRandomAlgorithmAnimation(LEDStrip& strip) {
@@ -31,7 +35,7 @@ void RunRandomAlgorithmAnimation(LEDStrip& strip) {
     using namespace BlinkenLawaSAT;
 
     static size_t a = 0;
-    // size_t a = random(22);
+    // size_t a = random(25);
     // a = 20;
     switch (a) {
     case 0:
@@ -86,7 +90,8 @@ void RunRandomAlgorithmAnimation(LEDStrip& strip) {
         RunSort(strip, "Cocktail-Shaker Sort", CocktailShakerSort, 770); // 58 secs
         break;
     case 17:
-        RunSort(strip, "BozoSort", BozoSort); // 20 secs (break time)
+        // runs for a fixed time, hence not calibrated
+        RunSort(strip, "BozoSort", BozoSort, 10000, /* calibrate */ false); // 20 secs (break time)
         break;
 
     /*------------------------------------------------------------------------*/
@@ -107,15 +112,27 @@ void RunRandomAlgorithmAnimation(LEDStrip& strip) {
         RunHash(strip, "Cuckoo Three\nHash Table", // 35 secs
                 CuckooHashingThree, 35000);
         break;
+    case 22:
+        RunHash(strip, "Robin Hood\nHash Table", // 36 secs
+                RobinHoodHT, 15000);
+        break;
+    case 23:
+        RunHash(strip, "Hopscotch\nHash Table", // 35 secs
+                HopscotchHT, 20000);
+        break;
+    case 24:
+        RunHash(strip, "Swiss Table\nHash Table", // 35 secs
+                SwissTableHT, 125000);
+        break;
 
     /*------------------------------------------------------------------------*/
 
-    case 22:
+    case 25:
         // RunLawaSAT(strip);
         break;
     }
     ++a;
-    a %= 22;
+    a %= random_algorithm_cycle;
 }
 
 } // namespace BlinkenAlgorithms
@@ -12,52 +12,69 @@
 #include <BlinkenAlgorithms/Color.hpp>
 #include <BlinkenAlgorithms/Control.hpp>
 
+#include <algorithm>
 #include <cassert>
 #include <random>
 #include <vector>
 
+#include "PdqSort.hpp"
 #include "TimSort.hpp"
 #include "WikiSort.hpp"
 
 namespace BlinkenSort {
 
 using namespace BlinkenAlgorithms;
+//! hide Arduino's ::micros(), which is ambiguous with the using-directive
+using BlinkenAlgorithms::micros;
 
+//! black sentinel of the default 16-bit Item, see ItemT::black
 static const uint16_t black = uint16_t(-1);
-static const uint16_t unsigned_negative = uint16_t(32678);
 
 /******************************************************************************/
-//! custom struct for array items, which allows detailed counting of comparisons
-
-class Item
+//! custom struct for array items, which allows detailed counting of comparisons.
+//! All accesses and comparisons are reported to the Instrumentation policy,
+//! which is resolved at compile time. The ValueType limits the array size: the
+//! largest value is reserved as black sentinel for empty and moved-from items,
+//! the second largest as tombstone of deleted hash table slots.
+//! uint16_t keeps items compact on microcontrollers, uint32_t allows more than
+//! 65535 items.
+
+template <typename Instrumentation, typename ValueType = uint16_t>
+class ItemT
 {
 public:
-    typedef uint16_t value_type;
+    typedef ValueType value_type;
+
+    //! sentinel value of empty and moved-from items
+    static constexpr value_type black = value_type(-1);
+
+    //! sentinel value of deleted slots in hash tables
+    static constexpr value_type tombstone = value_type(-2);
 
 public:
     value_type value_;
 
 public:
-    Item() { }
+    ItemT() { }
 
-    explicit Item(const value_type& d) : value_(d) { OnAccess(this); }
+    explicit ItemT(const value_type& d) : value_(d) { OnAccess(this); }
 
-    Item(const Item& v) : value_(v.value_) {
+    ItemT(const ItemT& v) : value_(v.value_) {
         OnAccess(this);
     }
 
-    Item(Item&& v) : value_(v.value_) {
+    ItemT(ItemT&& v) : value_(v.value_) {
         v.value_ = black;
         OnAccess(this);
     }
 
-    Item& operator = (const Item& a) {
+    ItemT& operator = (const ItemT& a) {
         value_ = a.value_;
         OnAccess(this);
         return *this;
     }
 
-    Item& operator = (Item&& a) {
+    ItemT& operator = (ItemT&& a) {
         value_ = a.value_;
         a.value_ = black;
         OnAccess(this);
@@ -70,13 +87,13 @@ public:
         return value_;
     }
 
-    Item& operator ++ (int) {
+    ItemT& operator ++ (int) {
         value_++;
         OnAccess(this);
         return *this;
     }
 
-    Item& operator -- (int) {
+    ItemT& operator -- (int) {
         value_--;
         OnAccess(this);
         return *this;
@@ -84,20 +101,20 @@ public:
 
     // *** bypass delay and updates
 
-    Item& SetNoDelay(const value_type& d) {
+    ItemT& SetNoDelay(const value_type& d) {
         value_ = d;
         OnAccess(this, /* with_delay */ false);
         return *this;
     }
 
-    Item& SetNoDelay(const Item& a) {
+    ItemT& SetNoDelay(const ItemT& a) {
         value_ = a.value_;
         OnAccess(this, /* with_delay */ false);
         return *this;
     }
 
-    void SwapNoDelay(Item& a) {
-        Item tmp;
+    void SwapNoDelay(ItemT& a) {
+        ItemT tmp;
         tmp.SetNoDelay(a);
         a.SetNoDelay(*this);
         SetNoDelay(tmp);
@@ -105,111 +122,232 @@ public:
 
     // *** comparisons
 
-    bool operator == (const Item& v) const {
+    bool operator == (const ItemT& v) const {
         OnComparison(*this, v);
         return (value_ == v.value_);
     }
 
-    bool operator != (const Item& v) const {
+    bool operator != (const ItemT& v) const {
         OnComparison(*this, v);
         return (value_ != v.value_);
     }
 
-    bool operator < (const Item& v) const {
+    bool operator < (const ItemT& v) const {
         OnComparison(*this, v);
         return (value_ < v.value_);
     }
 
-    bool operator <= (const Item& v) const {
+    bool operator <= (const ItemT& v) const {
         OnComparison(*this, v);
         return (value_ <= v.value_);
     }
 
-    bool operator > (const Item& v) const {
+    bool operator > (const ItemT& v) const {
         OnComparison(*this, v);
         return (value_ > v.value_);
     }
 
-    bool operator >= (const Item& v) const {
+    bool operator >= (const ItemT& v) const {
         OnComparison(*this, v);
         return (value_ >= v.value_);
     }
 
     // ternary comparison which counts just one
-    int cmp(const Item& v) const {
+    int cmp(const ItemT& v) const {
         OnComparison(*this, v);
         return (value_ == v.value_ ? 0 : value_ < v.value_ ? -1 : +1);
     }
 
     // *** comparisons without sound, counting or delay
 
-    bool equal_direct(const Item& v) const { return (value_ == v.value_); }
+    bool equal_direct(const ItemT& v) const { return (value_ == v.value_); }
 
-    bool less_direct(const Item& v) const { return (value_ < v.value_); }
+    bool less_direct(const ItemT& v) const { return (value_ < v.value_); }
 
-    bool greater_direct(const Item& v) const { return (value_ > v.value_); }
+    bool greater_direct(const ItemT& v) const { return (value_ > v.value_); }
 
     // *** access and comparison collectors
 
-    static void OnAccess(const Item* a, bool with_delay = true);
-    static void OnComparison(const Item&, const Item&);
+    static void OnAccess(const ItemT* a, bool with_delay = true) {
+        Instrumentation::OnAccess(a, with_delay);
+    }
+    static void OnComparison(const ItemT& a, const ItemT& b) {
+        Instrumentation::OnComparison(a, b);
+    }
 
-    static void IncrementCounter();
+    static void IncrementCounter() {
+        Instrumentation::template IncrementCounter<ItemT>();
+    }
 };
 
-using SortFunctionType = void (*)(Item * A, size_t n);
+template <typename Instrumentation, typename ValueType>
+constexpr ValueType ItemT<Instrumentation, ValueType>::black;
+template <typename Instrumentation, typename ValueType>
+constexpr ValueType ItemT<Instrumentation, ValueType>::tombstone;
 
-class SortAnimationBase
+//! virtual callbacks of an animation, one hook per item type.
+template <typename ItemType>
+class SortAnimationBaseT
 {
 public:
-    virtual void OnAccess(const Item* a, bool with_delay) = 0;
-    virtual void OnComparison(const Item* a, const Item* b) = 0;
+    virtual void OnAccess(const ItemType* a, bool with_delay) = 0;
+    virtual void OnComparison(const ItemType* a, const ItemType* b) = 0;
     virtual void IncrementCounter() = 0;
+
+    //! currently running animation of this thread
+    static BLINKEN_THREAD_LOCAL SortAnimationBaseT* hook;
 };
 
-static SortAnimationBase* sort_animation_hook = nullptr;
+template <typename ItemType>
+BLINKEN_THREAD_LOCAL SortAnimationBaseT<ItemType>*
+SortAnimationBaseT<ItemType>::hook = nullptr;
 
 // callbacks
 static void (* SoundAccessHook)(size_t i) = nullptr;
 static void (* DelayHook)() = nullptr;
 static void (* AlgorithmNameHook)(const char* name) = nullptr;
 static void (* ComparisonCountHook)(size_t count) = nullptr;
+//! may replace the delay_time of RunSort and RunHash, see Calibration.hpp
+static int32_t (* DelayTimeHook)(
+    const char* name, size_t n, int32_t delay_time) = nullptr;
+//! reports steps and seconds of a finished RunSort or RunHash
+static void (* RunTimeHook)(
+    const char* name, size_t n, uint64_t steps, double seconds,
+    int32_t delay_time) = nullptr;
 static unsigned intensity_flash_high = 2;
 
-void Item::OnAccess(const Item* a, bool with_delay) {
-    if (sort_animation_hook)
-        sort_animation_hook->OnAccess(a, with_delay);
-    if (SoundAccessHook)
-        SoundAccessHook(a->value_);
-}
+//! largest array_size for which SortAnimation caches the colors of all values,
+//! which takes 2 * sizeof(Color) = 8 bytes per item. Larger arrays compute the
+//! colors on each flash.
+#if ESP8266
+static const size_t s_palette_max_size = 1024;
+#else
+static const size_t s_palette_max_size = 65536;
+#endif
+
+/******************************************************************************/
+// Instrumentation Policies
+
+//! no instrumentation: items compile down to plain integers
+class NullInstrumentation
+{
+public:
+    template <typename ItemType>
+    static void OnAccess(const ItemType*, bool) { }
+
+    template <typename ItemType>
+    static void OnComparison(const ItemType&, const ItemType&) { }
+
+    template <typename ItemType>
+    static void IncrementCounter() { }
+};
+
+//! count accesses and comparisons in global counters, fully inlined
+class CountingInstrumentation
+{
+public:
+    static size_t accesses, comparisons;
 
-void Item::OnComparison(const Item& a, const Item& b) {
-    if (sort_animation_hook) {
-        sort_animation_hook->OnComparison(&a, &b);
+    template <typename ItemType>
+    static void OnAccess(const ItemType*, bool) { ++accesses; }
+
+    template <typename ItemType>
+    static void OnComparison(const ItemType&, const ItemType&) {
+        ++comparisons;
     }
-    if (SoundAccessHook) {
-        SoundAccessHook(a.value_);
-        SoundAccessHook(b.value_);
+
+    template <typename ItemType>
+    static void IncrementCounter() { ++comparisons; }
+
+    static void reset() { accesses = comparisons = 0; }
+};
+
+size_t CountingInstrumentation::accesses = 0;
+size_t CountingInstrumentation::comparisons = 0;
+
+//! forward to the running SortAnimation of the item type
+class AnimationInstrumentation
+{
+public:
+    template <typename ItemType>
+    static void OnAccess(const ItemType* a, bool with_delay) {
+        if (SortAnimationBaseT<ItemType>::hook)
+            SortAnimationBaseT<ItemType>::hook->OnAccess(a, with_delay);
     }
-}
 
-void Item::IncrementCounter() {
-    if (sort_animation_hook) {
-        sort_animation_hook->IncrementCounter();
+    template <typename ItemType>
+    static void OnComparison(const ItemType& a, const ItemType& b) {
+        if (SortAnimationBaseT<ItemType>::hook)
+            SortAnimationBaseT<ItemType>::hook->OnComparison(&a, &b);
     }
-}
+
+    template <typename ItemType>
+    static void IncrementCounter() {
+        if (SortAnimationBaseT<ItemType>::hook)
+            SortAnimationBaseT<ItemType>::hook->IncrementCounter();
+    }
+};
+
+//! forward to the running SortAnimation and to the SoundAccessHook
+class SoundAnimationInstrumentation : public AnimationInstrumentation
+{
+public:
+    template <typename ItemType>
+    static void OnAccess(const ItemType* a, bool with_delay) {
+        AnimationInstrumentation::OnAccess(a, with_delay);
+        if (SoundAccessHook && a->value_ < ItemType::tombstone)
+            SoundAccessHook(a->value_);
+    }
+
+    template <typename ItemType>
+    static void OnComparison(const ItemType& a, const ItemType& b) {
+        AnimationInstrumentation::OnComparison(a, b);
+        if (SoundAccessHook) {
+            if (a.value_ < ItemType::tombstone)
+                SoundAccessHook(a.value_);
+            if (b.value_ < ItemType::tombstone)
+                SoundAccessHook(b.value_);
+        }
+    }
+};
+
+//! default item type used by the animations
+using Item = ItemT<SoundAnimationInstrumentation>;
+
+//! item type for arrays of more than 65535 items, e.g. on large LED matrices
+using Item32 = ItemT<SoundAnimationInstrumentation, uint32_t>;
+
+using SortFunctionType = void (*)(Item * A, size_t n);
+
+using SortAnimationBase = SortAnimationBaseT<Item>;
 
 /******************************************************************************/
-// Sorting Algorithms
+// Sorting Algorithms: templates over the item type, such that they can run on
+// items with any instrumentation, or on plain integers if only comparisons and
+// moves are used.
+
+//! size and items of the array animated on this thread
+BLINKEN_THREAD_LOCAL size_t array_size;
+BLINKEN_THREAD_LOCAL std::vector<Item> array;
+
+//! array animated for each item type, the global array for Item.
+template <typename ItemType>
+std::vector<ItemType>& SortArray() {
+    static BLINKEN_THREAD_LOCAL std::vector<ItemType> a;
+    return a;
+}
 
-size_t array_size;
-std::vector<Item> array;
+template <>
+std::vector<Item>& SortArray<Item>() {
+    return array;
+}
 
 using std::swap;
 
 /******************************************************************************/
 // Selection Sort
 
+template <typename Item>
 void SelectionSort(Item* A, size_t n) {
     for (size_t i = 0; i < n - 1; ++i) {
         size_t j_min = i;
@@ -225,6 +363,7 @@ void SelectionSort(Item* A, size_t n) {
 /******************************************************************************/
 // Insertion Sort
 
+template <typename Item>
 void InsertionSort(Item* A, size_t n) {
     for (size_t i = 1; i < n && !g_terminate; ++i) {
         Item key = A[i];
@@ -240,6 +379,7 @@ void InsertionSort(Item* A, size_t n) {
 /******************************************************************************/
 // Bubble Sort
 
+template <typename Item>
 void BubbleSort(Item* A, size_t n) {
     for (size_t i = 0; i < n - 1; ++i) {
         for (size_t j = 0; j < n - 1 - i; ++j) {
@@ -253,6 +393,7 @@ void BubbleSort(Item* A, size_t n) {
 /******************************************************************************/
 // Cocktail Shaker Sort
 
+template <typename Item>
 void CocktailShakerSort(Item* A, size_t n) {
     size_t lo = 0, hi = n - 1, mov = lo;
 
@@ -289,9 +430,12 @@ enum QuickSortPivotType {
     PIVOT_SIZE
 };
 
-QuickSortPivotType g_quicksort_pivot = PIVOT_FIRST;
+//! pivot rule of the QuickSort running on this thread, such that racing sorts
+//! do not change each other's rule
+BLINKEN_THREAD_LOCAL QuickSortPivotType g_quicksort_pivot = PIVOT_FIRST;
 
 // pivot selection method
+template <typename Item>
 ssize_t QuickSortSelectPivot(Item* A, ssize_t lo, ssize_t hi) {
     if (g_quicksort_pivot == PIVOT_FIRST)
         return lo;
@@ -328,6 +472,7 @@ ssize_t QuickSortSelectPivot(Item* A, ssize_t lo, ssize_t hi) {
 /******************************************************************************/
 // Quick Sort LR (pointers left and right, Hoare's partition schema)
 
+template <typename Item>
 void QuickSortLR(Item* A, ssize_t lo, ssize_t hi) {
     if (g_terminate)
         return;
@@ -355,6 +500,7 @@ void QuickSortLR(Item* A, ssize_t lo, ssize_t hi) {
         QuickSortLR(A, i, hi);
 }
 
+template <typename Item>
 void QuickSortLR(Item* A, size_t n) {
     g_quicksort_pivot = (QuickSortPivotType)random(PIVOT_SIZE);
     QuickSortLR(A, 0, n - 1);
@@ -364,6 +510,7 @@ void QuickSortLR(Item* A, size_t n) {
 // Quick Sort LL (Lomuto partition scheme, two pointers at left, pivot is moved
 // to the right) (code by Timo Bingmann, based on CLRS' 3rd edition)
 
+template <typename Item>
 ssize_t PartitionLL(Item* A, ssize_t lo, ssize_t hi) {
     // pick pivot and move to back
     size_t p = QuickSortSelectPivot(A, lo, hi + 1);
@@ -385,6 +532,7 @@ ssize_t PartitionLL(Item* A, ssize_t lo, ssize_t hi) {
     return i;
 }
 
+template <typename Item>
 void QuickSortLL(Item* A, ssize_t lo, ssize_t hi) {
     if (lo < hi) {
         ssize_t mid = PartitionLL(A, lo, hi);
@@ -394,6 +542,7 @@ void QuickSortLL(Item* A, ssize_t lo, ssize_t hi) {
     }
 }
 
+template <typename Item>
 void QuickSortLL(Item* A, size_t n) {
     g_quicksort_pivot = (QuickSortPivotType)random(PIVOT_SIZE);
     QuickSortLL(A, 0, n - 1);
@@ -402,6 +551,7 @@ void QuickSortLL(Item* A, size_t n) {
 /******************************************************************************/
 // Dual-Pivot Quick Sort (code by Yaroslavskiy via Sebastian Wild)
 
+template <typename Item>
 void QuickSortDualPivotYaroslavskiy(Item* A, int left, int right) {
     if (right > left) {
         if (A[left] > A[right]) {
@@ -444,13 +594,48 @@ void QuickSortDualPivotYaroslavskiy(Item* A, int left, int right) {
     }
 }
 
+template <typename Item>
 void QuickSortDualPivot(Item* A, size_t n) {
     return QuickSortDualPivotYaroslavskiy(A, 0, n - 1);
 }
 
+/******************************************************************************/
+// Block Quick Sort (branchless block partitioning of Edelkamp and Weiss, using
+// the partition of pdqsort, with median of three pivot)
+
+template <typename Item>
+void BlockQuickSort(Item* A, ssize_t lo, ssize_t hi) {
+    // sort [lo,hi), recurse into the smaller part and loop on the larger one
+    while (hi - lo >= PdqSortNS::insertion_sort_threshold && !g_terminate) {
+        // median of three to A[lo], the largest to A[hi - 1], which the
+        // partition requires as sentinels
+        ssize_t mid = (lo + hi) / 2;
+        PdqSortNS::sort3(A + mid, A + lo, A + hi - 1, std::less<Item>());
+
+        ssize_t p = PdqSortNS::partition_right_branchless(
+            A + lo, A + hi, std::less<Item>()).first - A;
+
+        if (p - lo < hi - p) {
+            BlockQuickSort(A, lo, p);
+            lo = p + 1;
+        }
+        else {
+            BlockQuickSort(A, p + 1, hi);
+            hi = p;
+        }
+    }
+    PdqSortNS::insertion_sort(A + lo, A + hi, std::less<Item>());
+}
+
+template <typename Item>
+void BlockQuickSort(Item* A, size_t n) {
+    BlockQuickSort(A, 0, n);
+}
+
 /******************************************************************************/
 // Merge Sort (out-of-place with sentinels) (code by myself, Timo Bingmann)
 
+template <typename Item>
 void Merge(Item* A, size_t lo, size_t mid, size_t hi) {
     // allocate output
     Item out[hi - lo];
@@ -475,6 +660,7 @@ void Merge(Item* A, size_t lo, size_t mid, size_t hi) {
         A[lo + i] = std::move(out[i]);
 }
 
+template <typename Item>
 void MergeSort(Item* A, size_t lo, size_t hi) {
     if (g_terminate)
         return;
@@ -489,10 +675,12 @@ void MergeSort(Item* A, size_t lo, size_t hi) {
     }
 }
 
+template <typename Item>
 void MergeSort(Item* A, size_t n) {
     return MergeSort(A, 0, n);
 }
 
+template <typename Item>
 void MergeSortIterative(Item* A, size_t n) {
     for (size_t s = 1; s < n; s *= 2) {
         for (size_t i = 0; i + s < n; i += 2 * s) {
@@ -504,6 +692,7 @@ void MergeSortIterative(Item* A, size_t n) {
 /******************************************************************************/
 // Shell's Sort
 
+template <typename Item>
 void ShellSort(Item* A, size_t n) {
     size_t incs[16] = {
         1391376, 463792, 198768, 86961, 33936, 13776, 4592, 1968,
@@ -544,6 +733,7 @@ int largestPowerOfTwoLessThan(int n) {
     return k >> 1;
 }
 
+template <typename Item>
 void HeapSort(Item* A, size_t n) {
     size_t i = n / 2;
 
@@ -584,6 +774,7 @@ void HeapSort(Item* A, size_t n) {
 /******************************************************************************/
 // Cycle Sort (adapted from http://en.wikipedia.org/wiki/Cycle_sort)
 
+template <typename Item>
 void CycleSort(Item* A, size_t n) {
     size_t cycleStart = 0;
     size_t rank = 0;
@@ -623,6 +814,7 @@ void CycleSort(Item* A, size_t n) {
 // Radix Sort (counting sort, most significant digit (MSD) first, in-place
 // redistribute) (code by myself, Timo Bingmann)
 
+template <typename Item>
 void RadixSortMSD(Item* A, size_t n, size_t lo, size_t hi, size_t depth) {
     // radix and base calculations
     const unsigned int RADIX = 4;
@@ -663,6 +855,7 @@ void RadixSortMSD(Item* A, size_t n, size_t lo, size_t hi, size_t depth) {
     }
 }
 
+template <typename Item>
 void RadixSortMSD(Item* A, size_t n) {
     return RadixSortMSD(A, n, 0, n, 0);
 }
@@ -671,6 +864,7 @@ void RadixSortMSD(Item* A, size_t n) {
 // Radix Sort (counting sort, least significant digit (LSD) first, out-of-place
 // redistribute) (code by myself, Timo Bingmann)
 
+template <typename Item>
 void RadixSortLSD(Item* A, size_t n) {
     // radix and base calculations
     const unsigned int RADIX = 4;
@@ -704,29 +898,48 @@ void RadixSortLSD(Item* A, size_t n) {
 
 /******************************************************************************/
 
+template <typename Item>
 void StdSort(Item* A, size_t n) {
     std::sort(A, A + n);
 }
 
+template <typename Item>
 void StdStableSort(Item* A, size_t n) {
     std::stable_sort(A, A + n);
 }
 
 /******************************************************************************/
 
+template <typename Item>
 void WikiSort(Item* A, size_t n) {
     WikiSortNS::Sort(A, A + n, std::less<Item>());
 }
 
 /******************************************************************************/
 
+template <typename Item>
 void TimSort(Item* A, size_t n) {
     TimSortNS::timsort(A, A + n);
 }
 
+/******************************************************************************/
+// Pattern-defeating Quick Sort (code by Orson Peters), with the classic
+// partition and with branchless block partitioning
+
+template <typename Item>
+void PdqSort(Item* A, size_t n) {
+    PdqSortNS::pdqsort(A, A + n);
+}
+
+template <typename Item>
+void PdqSortBranchless(Item* A, size_t n) {
+    PdqSortNS::pdqsort_branchless(A, A + n);
+}
+
 /******************************************************************************/
 // BozoSort
 
+template <typename Item>
 void BozoSort(Item* A, size_t n) {
     unsigned long ts = millis() + 20000;
     while (millis() < ts) {
@@ -743,14 +956,16 @@ void BozoSort(Item* A, size_t n) {
 
 /******************************************************************************/
 
-template <typename LEDStrip>
-class SortAnimation : public SortAnimationBase
+template <typename LEDStrip, typename ItemType = Item>
+class SortAnimation : public SortAnimationBaseT<ItemType>
 {
 public:
+    using Hook = SortAnimationBaseT<ItemType>;
+
     SortAnimation(LEDStrip& strip, int32_t delay_time = 1000)
         : strip_(strip) {
         // hook sorting animation callbacks
-        sort_animation_hook = this;
+        Hook::hook = this;
 
         // set strip size
         array_size = strip_.size();
@@ -765,8 +980,11 @@ public:
     }
 
     ~SortAnimation() {
+        // unhook sorting animation callbacks
+        if (Hook::hook == this)
+            Hook::hook = nullptr;
         // free array
-        std::vector<Item>().swap(array);
+        std::vector<ItemType>().swap(array);
     }
 
     void array_randomize() {
@@ -781,26 +999,26 @@ public:
 
     void array_black() {
         for (uint32_t i = 0; i < array_size; ++i) {
-            array[i].SetNoDelay(black);
+            array[i].SetNoDelay(ItemType::black);
         }
     }
 
     void array_check() {
         // for (size_t i = 1; i < array_size; ++i) {
         //     if (array[i - 1] > array[i]) {
-        //         array[i - 1] = Item(black);
+        //         array[i - 1] = ItemType(black);
         //     }
         // }
         for (size_t i = 0; i < array_size; ++i) {
-            if (array[i] != Item(i)) {
-                array[i] = Item(black);
+            if (array[i] != ItemType(i)) {
+                array[i] = ItemType(ItemType::black);
             }
         }
     }
 
     unsigned intensity_last = 0;
 
-    void OnAccess(const Item* a, bool with_delay) override {
+    void OnAccess(const ItemType* a, bool with_delay) override {
         if (a < array.data() || a >= array.data() + array_size)
             return;
         flash(a - array.data(), with_delay);
@@ -815,7 +1033,7 @@ public:
             ComparisonCountHook(counter_value);
     }
 
-    void OnComparison(const Item* a, const Item* b) override {
+    void OnComparison(const ItemType* a, const ItemType* b) override {
         IncrementCounter();
         if (a >= array.data() && a < array.data() + array_size &&
             b >= array.data() && b < array.data() + array_size)
@@ -830,6 +1048,7 @@ public:
         pflush();
 
         delay_time_ = delay_time;
+        pacing_ = false;
 
         if (delay_time_ < 0) {
             frame_drop_ = -delay_time_;
@@ -839,8 +1058,36 @@ public:
             frame_drop_ = 0;
             frame_buffer_pos_ = 0;
         }
+        frame_buffer_.assign(frame_drop_, size_t(-1));
     }
 
+    /*!
+     * Pace frames adaptively instead of using a fixed delay or frame drop
+     * count: spread about expected_steps delayed flashes over run_time
+     * seconds, showing at most fps frames per second. After each frame, the
+     * time taken to compute and show it is measured, and the number of steps
+     * per frame and the delay are adjusted to the remaining steps and time.
+     * Steps beyond expected_steps are shown at fps.
+     */
+    void set_pacing(double fps, double run_time, uint64_t expected_steps) {
+        set_delay_time(0);
+
+        pacing_ = true;
+        pace_period_ = 1e6 / fps;
+        pace_run_time_ = run_time * 1e6;
+        pace_expected_ = expected_steps;
+        pace_steps_ = 0;
+        pace_frame_steps_ = 1;
+        pace_step_ = 0;
+        pace_start_ = pace_frame_end_ = micros();
+    }
+
+    //! number of steps shown per frame in pacing mode
+    size_t pace_frame_steps() const { return pace_frame_steps_; }
+
+    //! number of delayed flashes since construction
+    uint64_t step_count() const { return step_count_; }
+
     void set_enable_count(bool enable_count) {
         enable_count_ = enable_count;
     }
@@ -878,33 +1125,89 @@ public:
 
     uint16_t value_to_hue(size_t i) { return i * HSV_HUE_MAX / array_size; }
 
-    void flash_low(size_t i) {
-        if (array[i].value_ == black)
-            strip_.setPixel(i, 0);
-        else
-            strip_.setPixel(
-                i, HSVColor(value_to_hue(array[i].value_), 255,
-                            strip_.intensity()));
-    }
-
-    void flash_high(size_t i) {
+    //! intensity of flashed pixels
+    uint8_t intensity_high() const {
         size_t intensity_high = strip_.intensity();
         intensity_high = (intensity_high * intensity_flash_high) / 100;
         if (intensity_high > 255)
             intensity_high = 255;
+        return intensity_high;
+    }
 
-        if (array[i].value_ == black) {
-            strip_.setPixel(i, Color(intensity_high));
+    //! color of a value at normal intensity
+    Color color_low(size_t v) {
+        if (v == ItemType::black)
+            return Color(0);
+        if (v == ItemType::tombstone) {
+            uint8_t grey = strip_.intensity() / 8;
+            return Color(grey, grey, grey);
         }
-        else {
-            Color c = HSVColor(
-                value_to_hue(array[i].value_), 255, intensity_high);
-            c.white = intensity_high;
-            strip_.setPixel(i, c);
+        return HSVColor(value_to_hue(v), 255, strip_.intensity());
+    }
+
+    //! color of a flashed value
+    Color color_high(size_t v) {
+        uint8_t intensity = intensity_high();
+        if (v == ItemType::black || v == ItemType::tombstone)
+            return Color(intensity);
+        Color c = HSVColor(value_to_hue(v), 255, intensity);
+        c.white = intensity;
+        return c;
+    }
+
+    //! recompute the palette if intensity or array_size changed
+    void update_palette() {
+        if (palette_size_ == array_size &&
+            palette_intensity_ == strip_.intensity() &&
+            palette_flash_high_ == intensity_flash_high)
+            return;
+
+        palette_size_ = array_size;
+        palette_intensity_ = strip_.intensity();
+        palette_flash_high_ = intensity_flash_high;
+
+        size_t size = array_size <= s_palette_max_size ? array_size : 0;
+        palette_low_.resize(size);
+        palette_high_.resize(size);
+        for (size_t v = 0; v < size; ++v) {
+            palette_low_[v] = color_low(v);
+            palette_high_[v] = color_high(v);
         }
+        palette_black_high_ = color_high(ItemType::black);
+    }
+
+    //! memory used by the palette in bytes
+    size_t palette_bytes() const {
+        return (palette_low_.capacity() + palette_high_.capacity())
+               * sizeof(Color);
+    }
+
+    void flash_low(size_t i) {
+        update_palette();
+        size_t v = array[i].value_;
+        if (v == ItemType::black)
+            strip_.setPixel(i, Color(0));
+        else if (v < palette_low_.size())
+            strip_.setPixel(i, palette_low_[v]);
+        else
+            strip_.setPixel(i, color_low(v));
+    }
+
+    void flash_high(size_t i) {
+        update_palette();
+        size_t v = array[i].value_;
+        if (v == ItemType::black)
+            strip_.setPixel(i, palette_black_high_);
+        else if (v < palette_high_.size())
+            strip_.setPixel(i, palette_high_[v]);
+        else
+            strip_.setPixel(i, color_high(v));
     }
 
-    size_t frame_buffer_[256] = { 0 };
+    //! pixels to reset after the next frame. Holds frame_drop_ entries with a
+    //! fixed frame drop count, and the pixels of the current frame in pacing
+    //! mode.
+    std::vector<size_t> frame_buffer_;
     size_t frame_buffer_pos_ = 0;
     size_t frame_drop_ = 0;
 
@@ -930,11 +1233,63 @@ public:
         }
     }
 
+    //! finish a step in pacing mode, show a frame after pace_frame_steps_
+    void pace_step() {
+        if (++pace_step_ < pace_frame_steps_)
+            return;
+
+        if (!strip_.busy())
+            strip_.show();
+
+        for (size_t k : frame_buffer_) {
+            if (k < array_size)
+                flash_low(k);
+        }
+        frame_buffer_.clear();
+
+        pace_steps_ += pace_step_;
+        pace_step_ = 0;
+
+        // time taken to compute and show this frame
+        unsigned long now = micros();
+        double work = static_cast<unsigned long>(now - pace_frame_end_);
+        double period = std::max(pace_period_, work);
+        double sleep = pace_period_ - work;
+
+        double elapsed = static_cast<unsigned long>(now - pace_start_);
+        double remain = pace_run_time_ - elapsed;
+
+        if (pace_steps_ < pace_expected_ && remain > period) {
+            // microseconds per step to finish on time
+            double per_step = remain / (pace_expected_ - pace_steps_);
+
+            // at most double the steps per frame to damp the feedback of
+            // computing more steps per frame
+            double steps = std::min(period / per_step, 2.0 * pace_frame_steps_);
+            pace_frame_steps_ = steps < 1 ? 1 : static_cast<size_t>(steps);
+            sleep = pace_frame_steps_ * per_step - work;
+        }
+        else if (pace_steps_ < pace_expected_) {
+            // late: keep the frame rate and double the steps per frame
+            pace_frame_steps_ *= 2;
+        }
+
+        yield_delay(sleep > 0 ? static_cast<int32_t>(sleep) : 0);
+        pace_frame_end_ = micros();
+    }
+
     void flash(size_t i, bool with_delay = true) {
         if (!with_delay)
             return flash_low(i);
 
-        if (frame_drop_ == 0) {
+        ++step_count_;
+
+        if (pacing_) {
+            flash_high(i);
+            frame_buffer_.push_back(i);
+            pace_step();
+        }
+        else if (frame_drop_ == 0) {
             flash_high(i);
 
             if (!strip_.busy())
@@ -954,7 +1309,14 @@ public:
         if (!with_delay)
             return flash_low(i), flash_low(j);
 
-        if (frame_drop_ == 0) {
+        ++step_count_;
+
+        if (pacing_) {
+            flash_high(i), flash_high(j);
+            frame_buffer_.push_back(j), frame_buffer_.push_back(i);
+            pace_step();
+        }
+        else if (frame_drop_ == 0) {
             flash_high(i), flash_high(j);
 
             if (!strip_.busy())
@@ -973,10 +1335,12 @@ public:
 
     void pflush() {
         // reset pixels in this frame_buffer_pos_
-        for (size_t j = 0; j < frame_drop_; ++j) {
+        for (size_t j = 0; j < frame_buffer_.size(); ++j) {
             if (frame_buffer_[j] < array_size)
                 flash_low(frame_buffer_[j]);
         }
+        if (pacing_)
+            frame_buffer_.clear();
 
         frame_buffer_pos_ = frame_drop_ - 1;
         yield_delay();
@@ -987,27 +1351,72 @@ public:
 protected:
     LEDStrip& strip_;
 
+    //! array animated, the global array for Item
+    std::vector<ItemType>& array = SortArray<ItemType>();
+
     //! user given delay time.
     int32_t delay_time_;
 
     //! whether to count comparisons
     bool enable_count_;
+
+    //! number of delayed flashes
+    uint64_t step_count_ = 0;
+
+    //! adaptive pacing enabled by set_pacing()
+    bool pacing_ = false;
+
+    //! target frame period and run time in microseconds
+    double pace_period_ = 0, pace_run_time_ = 0;
+
+    //! expected and shown number of steps
+    uint64_t pace_expected_ = 0, pace_steps_ = 0;
+
+    //! steps per frame, and steps in the current frame
+    size_t pace_frame_steps_ = 1, pace_step_ = 0;
+
+    //! micros() at set_pacing() and at the end of the last frame
+    unsigned long pace_start_ = 0, pace_frame_end_ = 0;
+
+    //! cached low and high colors of values 0..array_size-1
+    std::vector<Color> palette_low_, palette_high_;
+
+    //! cached high color of black items
+    Color palette_black_high_;
+
+    //! parameters the palette was computed for
+    size_t palette_size_ = size_t(-1);
+    unsigned palette_intensity_ = 0, palette_flash_high_ = 0;
 };
 
-template <typename LEDStrip>
+//! Run a sort animation. If calibrate is set, the DelayTimeHook may replace
+//! delay_time and the RunTimeHook receives the measured run.
+template <typename LEDStrip, typename ItemType = Item>
 void RunSort(LEDStrip& strip, const char* algo_name,
-             void (*sort_function)(Item* A, size_t n),
-             int32_t delay_time = 10000) {
+             void (*sort_function)(ItemType* A, size_t n),
+             int32_t delay_time = 10000, bool calibrate = true) {
 
     uint32_t ts = millis();
 
-    SortAnimation<LEDStrip> ani(strip, delay_time);
+    if (calibrate && DelayTimeHook)
+        delay_time = DelayTimeHook(algo_name, strip.size(), delay_time);
+
+    SortAnimation<LEDStrip, ItemType> ani(strip, delay_time);
     if (AlgorithmNameHook)
         AlgorithmNameHook(algo_name);
     ani.array_randomize();
-    sort_function(array.data(), array_size);
 
-    static double total_time = 0, total_count = 0;
+    uint64_t steps = ani.step_count();
+    unsigned long ts_sort = micros();
+    sort_function(SortArray<ItemType>().data(), array_size);
+
+    if (calibrate && RunTimeHook) {
+        RunTimeHook(algo_name, array_size, ani.step_count() - steps,
+                    static_cast<unsigned long>(micros() - ts_sort) / 1e6,
+                    delay_time);
+    }
+
+    static BLINKEN_THREAD_LOCAL double total_time = 0, total_count = 0;
     total_time += (millis() - ts) / 1000.0;
     total_count += 1;
 
@@ -1025,6 +1434,91 @@ void RunSort(LEDStrip& strip, const char* algo_name,
     ani.yield_delay(2000000);
 }
 
+//! hook counting the steps an animation of the array would delay for
+template <typename ItemType>
+class SortStepCounter : public SortAnimationBaseT<ItemType>
+{
+public:
+    SortStepCounter(const ItemType* begin, const ItemType* end)
+        : begin_(begin), end_(end) { }
+
+    uint64_t steps = 0;
+
+    void OnAccess(const ItemType* a, bool with_delay) override {
+        if (with_delay && in_array(a))
+            ++steps;
+    }
+
+    void OnComparison(const ItemType* a, const ItemType* b) override {
+        if (in_array(a) || in_array(b))
+            ++steps;
+    }
+
+    void IncrementCounter() override { }
+
+private:
+    const ItemType* begin_, * end_;
+
+    bool in_array(const ItemType* a) const { return a >= begin_ && a < end_; }
+};
+
+/*!
+ * Run a sort with adaptive pacing instead of a hand-tuned delay time: the
+ * algorithm is first run on a copy of the array without animation to count
+ * its steps, then animated such that it takes about run_time seconds at up to
+ * fps frames per second. Both runs start from the same random seed, such that
+ * algorithms with random choices like the random-pivot QuickSorts take the
+ * same steps. Not suitable for algorithms running for a fixed time like
+ * BozoSort.
+ *
+ * Pacing is opt-in: the animation cycle in RandomAlgorithm.hpp and the
+ * blinken-sort programs still run RunSort() with delay times, which the
+ * Calibration adjusts where one is installed.
+ */
+template <typename LEDStrip, typename ItemType = Item>
+void RunSortPaced(LEDStrip& strip, const char* algo_name,
+                  void (*sort_function)(ItemType* A, size_t n),
+                  double run_time = 30, double fps = 50) {
+
+    uint32_t ts = millis();
+
+    SortAnimation<LEDStrip, ItemType> ani(strip);
+    if (AlgorithmNameHook)
+        AlgorithmNameHook(algo_name);
+    ani.array_randomize();
+
+    // count steps on a copy, without sound, and replay the same random
+    // choices in the animated run
+    uint32_t seed = random(0x7FFFFFFF);
+    std::vector<ItemType>& A = SortArray<ItemType>();
+    std::vector<ItemType> copy(array_size);
+    for (size_t i = 0; i < array_size; ++i)
+        copy[i].value_ = A[i].value_;
+
+    SortStepCounter<ItemType> counter(copy.data(), copy.data() + array_size);
+    SortAnimationBaseT<ItemType>::hook = &counter;
+    void (* sound_hook)(size_t i) = SoundAccessHook;
+    SoundAccessHook = nullptr;
+    randomSeed(seed);
+    sort_function(copy.data(), array_size);
+    SoundAccessHook = sound_hook;
+    SortAnimationBaseT<ItemType>::hook = &ani;
+
+    ani.set_pacing(fps, run_time, counter.steps);
+    randomSeed(seed);
+    sort_function(A.data(), array_size);
+
+    printf("%s running time: %.2f for %zu steps\n",
+           algo_name, (millis() - ts) / 1000.0,
+           static_cast<size_t>(counter.steps));
+
+    ani.set_delay_time(-4);
+    ani.set_enable_count(false);
+    ani.array_check();
+    ani.pflush();
+    ani.yield_delay(2000000);
+}
+
 /******************************************************************************/
 
 } // namespace BlinkenSort
@@ -0,0 +1,97 @@
+/*******************************************************************************
+ * lib/BlinkenAlgorithms/BlinkenAlgorithms/Animation/SortRace.hpp
+ *
+ * Race several sorting algorithms side by side on segments of one strip, each
+ * animated on its own thread.
+ *
+ * Copyright (C) 2018 Timo Bingmann <tb@panthema.net>
+ *
+ * All rights reserved. Published under the GNU General Public License v3.0
+ ******************************************************************************/
+
+#ifndef BLINKENALGORITHMS_ANIMATION_SORTRACE_HEADER
+#define BLINKENALGORITHMS_ANIMATION_SORTRACE_HEADER
+
+#include <BlinkenAlgorithms/Animation/Sort.hpp>
+#include <BlinkenAlgorithms/Strip/SegmentStrip.hpp>
+
+#include <string>
+
+namespace BlinkenSort {
+
+//! one algorithm of a RunSortRace
+template <typename ItemType = Item>
+struct SortRaceEntry {
+    const char* name;
+    void (* sort_function)(ItemType* A, size_t n);
+};
+
+/*!
+ * Race count algorithms: the strip is split into one segment per algorithm,
+ * separated by gap black pixels, and each algorithm sorts its own array on its
+ * own thread with the same delay_time, such that faster algorithms finish
+ * first. The StripCompositor shows the composed frames at up to fps.
+ *
+ * The sound, delay and counter hooks are not thread-safe, hence they are
+ * disabled during the race. The calibration hooks are not asked, the race
+ * uses delay_time as given. AlgorithmNameHook receives all names separated by
+ * " vs ".
+ */
+template <typename LEDStrip, typename ItemType = Item>
+void RunSortRace(LEDStrip& strip, const SortRaceEntry<ItemType>* algos,
+                 size_t count, int32_t delay_time = 10000,
+                 size_t gap = 2, double fps = 50) {
+
+    uint32_t ts = millis();
+
+    if (AlgorithmNameHook) {
+        std::string names;
+        for (size_t a = 0; a < count; ++a)
+            names += (a == 0 ? "" : " vs ") + std::string(algos[a].name);
+        AlgorithmNameHook(names.c_str());
+    }
+
+    void (* sound_hook)(size_t i) = SoundAccessHook;
+    void (* delay_hook)() = DelayHook;
+    void (* count_hook)(size_t count) = ComparisonCountHook;
+    SoundAccessHook = nullptr, DelayHook = nullptr;
+    ComparisonCountHook = nullptr;
+
+    for (size_t i = 0; i < strip.size(); ++i)
+        strip.setPixel(i, 0);
+
+    StripCompositor<LEDStrip> compositor(strip, fps);
+    compositor.split(count, gap);
+
+    using Segment = SegmentStrip<LEDStrip>;
+    compositor.run(
+        [&](Segment& segment, size_t a) {
+            SortAnimation<Segment, ItemType> ani(segment, delay_time);
+            ani.array_randomize();
+
+            uint32_t ts_sort = millis();
+            algos[a].sort_function(SortArray<ItemType>().data(), array_size);
+
+            printf("%s finished after %.2f\n",
+                   algos[a].name, (millis() - ts_sort) / 1000.0);
+
+            ani.set_delay_time(-4);
+            ani.set_enable_count(false);
+            ani.array_check();
+            ani.pflush();
+        });
+
+    SoundAccessHook = sound_hook, DelayHook = delay_hook;
+    ComparisonCountHook = count_hook;
+
+    printf("race running time: %.2f, %zu frames\n",
+           (millis() - ts) / 1000.0, compositor.frames());
+
+    delay_millis(2000);
+}
+
+} // namespace BlinkenSort
+
+#endif // !BLINKENALGORITHMS_ANIMATION_SORTRACE_HEADER
+
+/******************************************************************************/
@@ -0,0 +1,317 @@
+/*******************************************************************************
+ * lib/BlinkenAlgorithms/BlinkenAlgorithms/Animation/SortReplay.hpp
+ *
+ * Play a recorded sort trace on an LED strip through the same flash and delay
+ * path as SortAnimation, but without running the algorithm or any item hooks.
+ *
+ * Copyright (C) 2018 Timo Bingmann <tb@panthema.net>
+ *
+ * All rights reserved. Published under the GNU General Public License v3.0
+ ******************************************************************************/
+
+#ifndef BLINKENALGORITHMS_ANIMATION_SORTREPLAY_HEADER
+#define BLINKENALGORITHMS_ANIMATION_SORTREPLAY_HEADER
+
+#include <BlinkenAlgorithms/Animation/Sort.hpp>
+#include <BlinkenAlgorithms/Animation/SortTrace.hpp>
+#include <BlinkenAlgorithms/Extra/MappedFile.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+namespace BlinkenSort {
+
+//! maximum number of array values held in keyframes of a replay
+static const size_t s_keyframe_budget = 4 * 1024 * 1024;
+
+//! minimum number of events between two keyframes
+static const size_t s_keyframe_interval = 1024;
+
+/*!
+ * Replays a trace recorded by SortTraceRecorder. The trace's values are
+ * written directly into the animation's array, and accesses and comparisons
+ * flash pixels like SortAnimation does. On construction the whole trace is
+ * decoded once to take keyframes, copies of the array every few events, which
+ * make seek() cost at most one keyframe interval of decoding. The interval is
+ * doubled whenever the keyframes exceed keyframe_budget values.
+ */
+template <typename LEDStrip, typename ItemType = Item>
+class SortReplay : public SortAnimation<LEDStrip, ItemType>
+{
+public:
+    using Animation = SortAnimation<LEDStrip, ItemType>;
+    using value_type = typename ItemType::value_type;
+
+    //! replay a trace in memory, which must outlive the replay.
+    SortReplay(LEDStrip& strip, const uint8_t* data, size_t size,
+               int32_t delay_time = 1000,
+               size_t keyframe_budget = s_keyframe_budget)
+        : Animation(strip, delay_time),
+          reader_(data, size), delay_base_(delay_time) {
+        init(keyframe_budget);
+    }
+
+    //! replay a memory-mapped trace file.
+    SortReplay(LEDStrip& strip, const MappedFile& file,
+               int32_t delay_time = 1000,
+               size_t keyframe_budget = s_keyframe_budget)
+        : SortReplay(strip, file.data(), file.size(),
+                     delay_time, keyframe_budget) { }
+
+    //! true if the trace is valid and fits onto the strip
+    bool ok() const { return ok_; }
+
+    //! total number of events in the trace
+    uint64_t events() const { return events_; }
+
+    //! total number of delayed flashes in the trace
+    uint64_t steps() const { return steps_; }
+
+    //! number of events played or skipped so far
+    uint64_t event() const { return reader_.event(); }
+
+    //! number of events between keyframes
+    size_t keyframe_interval() const { return interval_; }
+
+    //! number of keyframes taken
+    size_t keyframes() const { return keyframes_.size(); }
+
+    //! play the next event, returns false at the end of the trace.
+    bool step() {
+        SortTraceEvent ev;
+        if (!reader_.next(ev))
+            return false;
+        apply(ev);
+        step_ += is_step(ev);
+
+        static const uint32_t temp = SortTraceEvent::temporary;
+        size_t i = ev.index[0], j = ev.index[1];
+        switch (ev.type) {
+        case SortTraceEvent::Access:
+        case SortTraceEvent::AccessNoDelay:
+            if (SoundAccessHook)
+                SoundAccessHook(ev.value[0]);
+            if (i != temp)
+                this->flash(i, ev.type == SortTraceEvent::Access);
+            break;
+        case SortTraceEvent::Comparison:
+            if (SoundAccessHook) {
+                SoundAccessHook(ev.value[0]);
+                SoundAccessHook(ev.value[1]);
+            }
+            this->IncrementCounter();
+            if (i != temp && j != temp)
+                this->flash(i, j, /* with_delay */ true);
+            else if (i != temp)
+                this->flash(i);
+            else if (j != temp)
+                this->flash(j);
+            break;
+        case SortTraceEvent::Counter:
+            this->IncrementCounter();
+            break;
+        }
+        return true;
+    }
+
+    //! play up to count events, stops early at the end of the trace or on
+    //! g_terminate. Returns the number of events played.
+    uint64_t play(uint64_t count = uint64_t(-1)) {
+        uint64_t e = 0;
+        while (e < count && !g_terminate && step())
+            ++e;
+        return e;
+    }
+
+    //! jump to the state before event target without flashing, then redraw
+    //! all pixels.
+    void seek(uint64_t target) {
+        if (target > events_)
+            target = events_;
+
+        size_t k = target / interval_;
+        if (k >= keyframes_.size())
+            k = keyframes_.size() - 1;
+
+        const Keyframe& kf = keyframes_[k];
+        reader_.seek(kf.pos);
+        this->counter_value = kf.counter;
+        step_ = kf.step;
+        const value_type* values = keyframe_values_.data() + k * n_;
+        for (size_t i = 0; i < n_; ++i)
+            this->array[i].value_ = values[i];
+
+        SortTraceEvent ev;
+        while (reader_.event() < target && reader_.next(ev)) {
+            apply(ev);
+            step_ += is_step(ev);
+            if (ev.type >= SortTraceEvent::Comparison)
+                ++this->counter_value;
+        }
+
+        if (ComparisonCountHook)
+            ComparisonCountHook(this->counter_value);
+
+        this->set_delay_time(this->delay_time_);
+        for (size_t i = 0; i < n_; ++i)
+            this->flash_low(i);
+        this->strip_.show();
+    }
+
+    //! restart at the first event
+    void rewind() { seek(0); }
+
+    /*!
+     * Scale the playback speed relative to the delay_time given on
+     * construction: a positive delay is divided by speed, a negative frame
+     * drop count is multiplied by speed.
+     */
+    void set_speed(float speed) {
+        if (speed <= 0)
+            return;
+
+        int32_t delay_time = delay_base_;
+        if (delay_base_ > 0) {
+            delay_time = std::lround(delay_base_ / speed);
+        }
+        else if (delay_base_ < 0) {
+            long drop = std::lround(-delay_base_ * speed);
+            delay_time = drop < 1 ? -1 : -drop;
+        }
+        this->set_delay_time(delay_time);
+    }
+
+    //! pace the remaining trace to play for about the given number of
+    //! seconds, at most fps frames per second.
+    void set_duration(double seconds, double fps = 50) {
+        this->set_pacing(fps, seconds, steps_ - step_);
+    }
+
+private:
+    SortTraceReader reader_;
+
+    //! delay_time given on construction, scaled by set_speed()
+    int32_t delay_base_;
+
+    bool ok_ = false;
+
+    //! array size of the trace
+    size_t n_ = 0;
+
+    //! total number of events and logical time
+    uint64_t events_ = 0, steps_ = 0;
+
+    //! number of delayed flashes played or skipped so far
+    uint64_t step_ = 0;
+
+    //! number of events between keyframes
+    size_t interval_ = s_keyframe_interval;
+
+    //! decoder state, comparison counter and steps at a keyframe
+    struct Keyframe {
+        SortTraceReader::Position pos;
+        size_t counter;
+        uint64_t step;
+    };
+
+    std::vector<Keyframe> keyframes_;
+
+    //! array values of all keyframes, n_ per keyframe
+    std::vector<value_type> keyframe_values_;
+
+    //! true if the event flashes with delay, as counted by SortStepCounter
+    bool is_step(const SortTraceEvent& ev) const {
+        static const uint32_t temp = SortTraceEvent::temporary;
+        return (ev.type == SortTraceEvent::Access && ev.index[0] != temp) ||
+               (ev.type == SortTraceEvent::Comparison &&
+                (ev.index[0] != temp || ev.index[1] != temp));
+    }
+
+    //! true if all indexes of an event are in the array or temporary
+    bool in_range(const SortTraceEvent& ev) const {
+        for (unsigned k = 0; k < 2; ++k) {
+            if (ev.index[k] != SortTraceEvent::temporary && ev.index[k] >= n_)
+                return false;
+        }
+        return true;
+    }
+
+    //! write the values of an event into the array
+    void apply(const SortTraceEvent& ev) {
+        for (unsigned k = 0; k < 2; ++k) {
+            if (ev.index[k] < n_)
+                this->array[ev.index[k]].value_ = ev.value[k];
+        }
+    }
+
+    //! decode the trace once, taking keyframes
+    void init(size_t keyframe_budget) {
+        if (!reader_.ok())
+            return;
+
+        n_ = reader_.initial().size();
+        if (n_ > this->strip_.size()) {
+            fprintf(stderr, "SortReplay: trace of %zu items exceeds strip\n",
+                    n_);
+            return;
+        }
+
+        array_size = n_;
+        this->array.resize(n_);
+        for (size_t i = 0; i < n_; ++i)
+            this->array[i].value_ = reader_.initial()[i];
+
+        SortTraceEvent ev;
+        size_t counter = 0;
+        while (true) {
+            if (reader_.event() % interval_ == 0) {
+                keyframes_.push_back(
+                    Keyframe { reader_.position(), counter, steps_ });
+                for (size_t i = 0; i < n_; ++i)
+                    keyframe_values_.push_back(this->array[i].value_);
+
+                if (keyframe_values_.size() > keyframe_budget &&
+                    keyframes_.size() > 1)
+                    thin_keyframes();
+            }
+            if (!reader_.next(ev))
+                break;
+            if (!in_range(ev)) {
+                fprintf(stderr, "SortReplay: trace index out of range\n");
+                return;
+            }
+            apply(ev);
+            steps_ += is_step(ev);
+            if (ev.type >= SortTraceEvent::Comparison)
+                ++counter;
+        }
+        if (!reader_.ok())
+            return;
+
+        events_ = reader_.event();
+        ok_ = true;
+        rewind();
+    }
+
+    //! drop every second keyframe and double the interval
+    void thin_keyframes() {
+        size_t j = 0;
+        for (size_t k = 0; k < keyframes_.size(); k += 2, ++j) {
+            keyframes_[j] = keyframes_[k];
+            std::copy(keyframe_values_.begin() + k * n_,
+                      keyframe_values_.begin() + (k + 1) * n_,
+                      keyframe_values_.begin() + j * n_);
+        }
+        keyframes_.resize(j);
+        keyframe_values_.resize(j * n_);
+        interval_ *= 2;
+    }
+};
+
+} // namespace BlinkenSort
+
+#endif // !BLINKENALGORITHMS_ANIMATION_SORTREPLAY_HEADER
+
+/******************************************************************************/
@@ -9,6 +9,19 @@
 #ifndef BLINKENALGORITHMS_ANIMATION_SORTSOUND_HEADER
 #define BLINKENALGORITHMS_ANIMATION_SORTSOUND_HEADER
 
+#include <BlinkenAlgorithms/Animation/Sort.hpp>
+#include <BlinkenAlgorithms/Extra/SPSCRing.hpp>
+#include <BlinkenAlgorithms/Extra/WavWriter.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <utility>
+#include <vector>
+
 //! all time counters in the sound system are in sample units.
 static const size_t s_samplerate = 44100;
 
@@ -18,171 +31,251 @@ bool g_sound_on = true;
 //! the duration each sound is sustained
 float g_sound_sustain = 0.05;
 
-//! limit the number of oscillators to avoid overloading the callback
+//! default limit of oscillators to avoid overloading the callback
 static const size_t s_max_oscillators = 64;
 
-//! Oscillator generating sine or triangle waves
-class Oscillator
+/*!
+ * Mixes triangle wave oscillators with ADSR envelopes into stereo sample
+ * blocks. The oscillator state is kept as structure of arrays, and each
+ * oscillator is rendered into the whole block at once: the phase and the
+ * envelope are linear functions of the sample time within each envelope
+ * segment, such that the inner loop has no branches and is vectorized.
+ *
+ * Oscillator slots are allocated from a free list, active ones are kept in a
+ * min-heap on their end time, from which finished oscillators are recycled
+ * and, when all slots are busy, the one ending first is stolen if the policy
+ * allows it.
+ */
+class SoundMixer
 {
-protected:
-    //! frequency of generated wave
-    float m_freq;
-
-    //! position on array normalized to [0,65536)
-    uint32_t m_relpos;
-
-    //! start and end of wave in sample time
-    size_t m_tstart, m_tend;
-
-    //! duration of oscillation note
-    size_t m_duration;
-
 public:
-    //! construct new oscillator
-    Oscillator(float freq, size_t relpos, size_t tstart, size_t duration)
-        : m_freq(freq), m_relpos(relpos),
-          m_tstart(tstart), m_tend(m_tstart + duration),
-          m_duration(duration)
-    { }
-
-    uint32_t relpos() const { return m_relpos; }
-
-    // *** Wave Forms
+    //! what to do with a new note when all oscillators are busy
+    enum class Policy { Drop, StealOldest };
 
-    //! triangle wave
-    static int32_t wave_sin(int32_t x) {
-        x &= 0xFFFF;
-        return sin(static_cast<float>(x) / 0xFFFF) * 0xFFFF;
+    explicit SoundMixer(size_t max_oscillators = s_max_oscillators,
+                        Policy policy = Policy::Drop) {
+        set_max_oscillators(max_oscillators);
+        set_policy(policy);
     }
 
-    //! triangle wave
-    static int32_t wave_triangle(int32_t x) {
-        x &= 0xFFFF;
-
-        if (x <= 65536 / 4)
-            return x;
-        if (x <= 3 * 65536 / 4)
-            return 65536 / 2 - x;
-        return x - 65536;
+    //! change number of oscillator slots, removes all oscillators.
+    void set_max_oscillators(size_t max_oscillators) {
+        tstart_.resize(max_oscillators), tend_.resize(max_oscillators);
+        phase_inc_.resize(max_oscillators);
+        gain_l_.resize(max_oscillators), gain_r_.resize(max_oscillators);
+        active_.reserve(max_oscillators);
+        free_.reserve(max_oscillators);
+        clear();
     }
 
-    //! picking a waveform
-    static int32_t wave(int32_t x) {
-        // return wave_sin(x);
-        return wave_triangle(x);
-    }
-
-    // *** Envelope
-
-    //! envelope applied to wave (uses ADSR)
-    int32_t envelope(size_t i) const {
-        static const uint32_t unit = 65536;
-        uint32_t x = i / m_duration;
-        if (x > unit) x = unit;
-
-        // simple envelope functions:
+    void set_policy(Policy policy) { policy_ = policy; }
+
+    //! add an oscillator started at sample time tstart. p is the current
+    //! sample time, oscillators ending before it are recycled.
+    void add(float freq, uint32_t relpos,
+             size_t p, size_t tstart, size_t duration) {
+        // recycle finished oscillators
+        while (!active_.empty() && active_.front().first <= p) {
+            std::pop_heap(active_.begin(), active_.end(), ActiveLater());
+            free_.push_back(active_.back().second);
+            active_.pop_back();
+        }
 
-        // return 1.0 - x;
-        // return cos(M_PI_2 * x);
+        uint32_t i;
+        if (!free_.empty()) {
+            i = free_.back();
+            free_.pop_back();
+        }
+        else if (policy_ == Policy::StealOldest && !active_.empty()) {
+            std::pop_heap(active_.begin(), active_.end(), ActiveLater());
+            i = active_.back().second;
+            active_.pop_back();
+            stolen_.fetch_add(1, std::memory_order_relaxed);
+        }
+        else {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
 
-        // *** ADSR envelope
+        tstart_[i] = tstart;
+        tend_[i] = tstart + duration;
+        // phase advance per sample, one wave period is 2^32
+        phase_inc_[i] = static_cast<uint32_t>(
+            static_cast<double>(freq) / s_samplerate * 4294967296.0);
+        // pan by position on array [0,65536)
+        gain_l_[i] = s_gain * static_cast<float>(65535 - relpos) / 65536;
+        gain_r_[i] = s_gain * static_cast<float>(relpos) / 65536;
+
+        active_.emplace_back(tend_[i], i);
+        std::push_heap(active_.begin(), active_.end(), ActiveLater());
+    }
 
-        static const uint32_t attack = 0.2 * unit;   // percentage of duration
-        static const uint32_t decay = 0.2 * unit;    // percentage of duration
-        static const uint32_t sustain = 0.8 * unit;  // percentage of amplitude
-        static const uint32_t release = 0.2 * unit;  // percentage of duration
+    //! remove all oscillators
+    void clear() {
+        active_.clear();
+        free_.clear();
+        for (size_t i = tend_.size(); i != 0; --i)
+            free_.push_back(static_cast<uint32_t>(i - 1));
+    }
 
-        if (x < attack)
-            return unit / attack * x;
+    //! number of oscillator slots
+    size_t max_oscillators() const { return tend_.size(); }
+
+    //! number of active oscillators, including ones not yet recycled
+    size_t size() const { return active_.size(); }
+
+    //! number of notes dropped because all oscillators were busy
+    size_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+    //! number of oscillators replaced by a newer note
+    size_t stolen() const { return stolen_.load(std::memory_order_relaxed); }
+
+    //! render samples [p, p + size) into left and right
+    void render(size_t p, size_t size, float* left, float* right) const {
+        std::fill(left, left + size, 0.0f);
+        std::fill(right, right + size, 0.0f);
+
+        for (const ActiveEntry& a : active_) {
+            size_t k = a.second;
+            if (tend_[k] <= p || tstart_[k] >= p + size)
+                continue;
+
+            // ADSR envelope: attack 20%, decay 20% to sustain level 0.8,
+            // release in the last 20% of duration.
+            size_t duration = tend_[k] - tstart_[k];
+            size_t seg_end[4] = {
+                duration / 5, 2 * duration / 5, 4 * duration / 5, duration
+            };
+            float seg_begin[4] = { 0.0f, 1.0f, 0.8f, 0.8f };
+            float seg_final[4] = { 1.0f, 0.8f, 0.8f, 0.0f };
+
+            size_t trel = p > tstart_[k] ? p - tstart_[k] : 0;
+            size_t trel_end = std::min(duration, p + size - tstart_[k]);
+
+            size_t seg_start = 0;
+            for (size_t s = 0; s < 4 && trel < trel_end; ++s) {
+                if (trel >= seg_end[s]) {
+                    seg_start = seg_end[s];
+                    continue;
+                }
 
-        if (x < attack + decay)
-            return unit - (x - attack) * (unit - sustain) / decay;
+                // envelope is linear within segment: e0 + slope * i
+                size_t end = std::min(seg_end[s], trel_end);
+                float slope = (seg_final[s] - seg_begin[s])
+                              / (seg_end[s] - seg_start);
+                float e0 = seg_begin[s] + slope * (trel - seg_start);
 
-        if (x < unit - release)
-            return sustain;
+                size_t off = tstart_[k] + trel - p;
+                render_segment(
+                    left + off, right + off, static_cast<int>(end - trel),
+                    static_cast<uint32_t>(trel) * phase_inc_[k],
+                    phase_inc_[k], e0, slope, gain_l_[k], gain_r_[k]);
 
-        return sustain / release * (unit - x);
+                trel = end;
+                seg_start = seg_end[s];
+            }
+        }
     }
 
-    // *** Generate Wave and Mix
-
-    int32_t mix_value(size_t p) const {
-        if (p < m_tstart)
-            return 0;
-        if (p >= m_tend)
-            return 0;
-
-        size_t trel = (p - m_tstart);
+    //! triangle wave of period 65536 and amplitude 16384, without branches
+    static int32_t wave_triangle(int32_t x) {
+        return 16384 - std::abs(((x + 16384) & 0xFFFF) - 32768);
+    }
 
-        return wave(trel * 65536 * m_freq / s_samplerate)
-               * envelope(trel * 65556);
+    //! soft clip both channels to int16 range and interleave them.
+    static void soft_clip(const float* left, const float* right, size_t size,
+                          int16_t* out) {
+        for (size_t i = 0; i < size; ++i) {
+            out[2 * i + 0] = static_cast<int16_t>(soft_clip(left[i]));
+            out[2 * i + 1] = static_cast<int16_t>(soft_clip(right[i]));
+        }
     }
 
-    //! return start time
-    size_t tstart() const {
-        return m_tstart;
+    //! compress values above 30000 by half, again above 31000, and clip at
+    //! 32000, using only min and max.
+    static float soft_clip(float v) {
+        v = std::min(v, 30000.0f) + std::max(v - 30000.0f, 0.0f) * 0.5f;
+        v = std::min(v, 31000.0f) + std::max(v - 31000.0f, 0.0f) * 0.5f;
+        v = std::max(v, -30000.0f) + std::min(v + 30000.0f, 0.0f) * 0.5f;
+        v = std::max(v, -31000.0f) + std::min(v + 31000.0f, 0.0f) * 0.5f;
+        return std::max(std::min(v, 32000.0f), -32000.0f);
     }
 
-    //! true if the oscillator is silent at time p
-    bool is_done(size_t p) const {
-        return (p >= m_tend);
+private:
+    //! output amplitude of one oscillator at full envelope, matches the
+    //! former integer mixer: 65536 >> 12 * volume 15000 >> 20.
+    static constexpr float s_gain = 16.0f * 15000.0f / 1048576.0f;
+
+    //! start and end of each oscillator in sample time
+    std::vector<size_t> tstart_, tend_;
+    //! phase increment per sample
+    std::vector<uint32_t> phase_inc_;
+    //! stereo gains
+    std::vector<float> gain_l_, gain_r_;
+
+    //! end time and slot of an active oscillator
+    using ActiveEntry = std::pair<size_t, uint32_t>;
+
+    //! comparator for a min-heap on end time
+    struct ActiveLater {
+        bool operator () (const ActiveEntry& a, const ActiveEntry& b) const {
+            return a.first > b.first;
+        }
+    };
+
+    //! min-heap of active oscillators on end time
+    std::vector<ActiveEntry> active_;
+    //! stack of free oscillator slots
+    std::vector<uint32_t> free_;
+
+    //! policy when all oscillators are busy
+    Policy policy_;
+
+    //! counters, read from other threads
+    std::atomic<size_t> dropped_ { 0 }, stolen_ { 0 };
+
+    //! add n samples of one oscillator within one envelope segment
+    static void render_segment(
+        float* left, float* right, int n, uint32_t phase, uint32_t phase_inc,
+        float e0, float slope, float gain_l, float gain_r) {
+        for (int i = 0; i < n; ++i) {
+            uint32_t ph = phase + static_cast<uint32_t>(i) * phase_inc;
+            float v = wave_triangle(ph >> 16) * (e0 + slope * i);
+            left[i] += v * gain_l;
+            right[i] += v * gain_r;
+        }
     }
 };
 
-//! array of oscillators
-static std::vector<Oscillator> s_osclist;
+//! oscillators, owned by the audio callback
+static SoundMixer s_mixer;
 
 //! global timestamp of callback in sound sample units
 static size_t s_pos = 0;
 
-//! add an oscillator to the list (reuse finished ones)
-static void add_oscillator(float freq, size_t relpos,
-                           size_t p, size_t pstart, size_t duration) {
-    // find free oscillator
-    size_t oldest = 0, toldest = std::numeric_limits<size_t>::max();
-    for (size_t i = 0; i < s_osclist.size(); ++i)
-    {
-        if (s_osclist[i].is_done(p)) {
-            s_osclist[i] = Oscillator(freq, relpos, pstart, duration);
-            return;
-        }
+//! array accesses since last callback, written by the sorting thread and read
+//! by the audio callback. Neither side blocks, accesses are dropped if the
+//! ring is full, which only happens if the callback stalls.
+static BlinkenAlgorithms::SPSCRing<uint32_t, 4096> s_access_ring;
 
-        if (s_osclist[i].tstart() < toldest) {
-            oldest = i;
-            toldest = s_osclist[i].tstart();
-        }
-    }
+//! number of accesses dropped due to a full ring
+static std::atomic<size_t> s_access_dropped { 0 };
 
-    if (s_osclist.size() < s_max_oscillators)
-    {
-        // add new one
-        s_osclist.push_back(Oscillator(freq, relpos, pstart, duration));
-    }
-    else
-    {
-        // replace oldest oscillator
-        (void)oldest;
-        // s_osclist[oldest] = Oscillator(freq, relpos, pstart, duration);
-    }
-}
-
-//! list of array accesses since last callback
-static std::vector<unsigned> s_access_list;
-
-#if !TEENSYDUINO
-// mutex to s_access_list
-static std::mutex s_mutex_access_list;
-#endif
+//! request from main thread to reset sound data in the next callback
+static std::atomic<bool> s_sound_reset { false };
 
 //! "public" function to add a new array access
-static void OnSoundAccess(size_t i) {
+void OnSoundAccess(size_t i) {
     if (!g_sound_on) return;
     if (i == BlinkenSort::black) return;
 
-#if !TEENSYDUINO
-    std::unique_lock<std::mutex> lock(s_mutex_access_list);
-#endif
-    s_access_list.push_back(i);
+    if (!s_access_ring.push(i))
+        s_access_dropped.fetch_add(1, std::memory_order_relaxed);
+}
+
+//! return number of accesses dropped due to a full ring
+size_t SoundAccessDropped() {
+    return s_access_dropped.load(std::memory_order_relaxed);
 }
 
 //! function mapping array index (normalized to [0,1]) to frequency
@@ -190,18 +283,52 @@ static float arrayindex_to_frequency(float aindex) {
     return 120 + 1200 * (aindex * aindex);
 }
 
-//! reset internal sound data (called from main thread)
-void SoundReset() {
-#if !TEENSYDUINO
-    std::unique_lock<std::mutex> lock(s_mutex_access_list);
-#endif
+//! configure oscillator pool, call before the audio device is started.
+void SoundSetOscillators(size_t max_oscillators, SoundMixer::Policy policy) {
+    s_mixer.set_max_oscillators(max_oscillators);
+    s_mixer.set_policy(policy);
+}
 
-    s_pos = 0;
-    s_osclist.clear();
+//! return number of notes dropped because all oscillators were busy
+size_t SoundOscillatorsDropped() {
+    return s_mixer.dropped();
+}
+
+//! return number of oscillators replaced by newer notes
+size_t SoundOscillatorsStolen() {
+    return s_mixer.stolen();
+}
+
+//! reset internal sound data (called from main thread, performed by the next
+//! callback which owns the sound data)
+void SoundReset() {
+    s_sound_reset = true;
 }
 
 static size_t array_max = 0;
 
+//! start a note for an array access at sample time tstart
+static void SoundAddNote(uint32_t access, size_t tstart) {
+    float freq = arrayindex_to_frequency(
+        access / static_cast<float>(array_max));
+    uint32_t relpos = access;
+    relpos = relpos * 65536 / array_max;
+
+    s_mixer.add(freq, relpos, s_pos, tstart, g_sound_sustain * s_samplerate);
+}
+
+//! render the oscillators into size stereo frames of data and advance the
+//! sample timestamp
+static void SoundRenderBlock(int16_t* data, size_t size) {
+    static std::vector<float> left, right;
+    left.resize(size), right.resize(size);
+
+    s_mixer.render(s_pos, size, left.data(), right.data());
+    SoundMixer::soft_clip(left.data(), right.data(), size, data);
+
+    s_pos += size;
+}
+
 //! sound generator callback run by SDL
 void SoundCallback(void* /* udata */, uint8_t* stream, int len) {
     if (!g_sound_on) {
@@ -217,113 +344,79 @@ void SoundCallback(void* /* udata */, uint8_t* stream, int len) {
     int16_t* data = (int16_t*)stream;
     size_t size = len / (2 * sizeof(int16_t));
 
-    // fetch new access list and create oscillators
+    if (s_sound_reset.exchange(false)) {
+        p = 0;
+        s_mixer.clear();
+        s_access_ring.clear();
+    }
+
+    // fetch new accesses and create oscillators
     {
-#if !TEENSYDUINO
-        std::unique_lock<std::mutex> lock(s_mutex_access_list);
-#endif
-
-        // spread out access list over time of one callback
-        float pscale = (float)size / s_access_list.size();
-
-        for (size_t i = 0; i < s_access_list.size(); ++i)
-        {
-            float freq = arrayindex_to_frequency(
-                s_access_list[i] / static_cast<float>(array_max));
-            uint32_t relpos = s_access_list[i];
-            relpos = relpos * 65536 / array_max;
-
-            add_oscillator(freq, relpos,
-                           p, p + i * pscale,
-                           g_sound_sustain * s_samplerate);
-        }
+        // spread out accesses over time of one callback
+        size_t count = s_access_ring.size();
+        float pscale = (float)size / count;
 
-        s_access_list.clear();
+        uint32_t access;
+        for (size_t i = 0; i < count && s_access_ring.pop(access); ++i)
+            SoundAddNote(access, p + i * pscale);
     }
 
-    static int64_t volume_factor = 15000;
-    int64_t this_maximum = 0.0;
-    static int64_t total_maximum = 0.0;
+    // render oscillators, then soft clip into output
+    SoundRenderBlock(data, size);
+}
 
-    for (size_t i = 0; i < size; ++i) {
-        int64_t vl = 0, vr = 0;
+/******************************************************************************/
+// Offline Rendering
 
-        for (std::vector<Oscillator>::const_iterator it = s_osclist.begin();
-             it != s_osclist.end(); ++it)
-        {
-            if (!it->is_done(p)) {
-                int64_t v = it->mix_value(p + i) >> 12;
-                vl += v * (65536 - it->relpos() - 1) / 65536;
-                vr += v * (it->relpos()) / 65536;
-            }
-        }
+//! array access at a sample time, recorded for offline rendering
+struct SoundEvent {
+    size_t time;
+    uint32_t index;
+};
 
-        vl = (vl * volume_factor) >> 20;
-        vr = (vr * volume_factor) >> 20;
-
-        this_maximum = std::max(this_maximum, std::abs(vl));
-        this_maximum = std::max(this_maximum, std::abs(vr));
-
-        if (std::max(vl, vr) > 30000) {
-            vl -= 30000, vr -= 30000;
-            vl /= 2, vr /= 2;
-            vl += 30000, vr += 30000;
-            if (std::max(vl, vr) > 31000) {
-                vl -= 31000, vr -= 31000;
-                vl /= 2, vr /= 2;
-                vl += 31000, vr += 31000;
-                if (std::max(vl, vr) > 32000) {
-                    vl = std::min<int64_t>(vl, 32000ll);
-                    vr = std::min<int64_t>(vr, 32000ll);
-                    // std::cout << "clip upper" << std::endl;
-                }
-            }
-        }
-        if (std::min(vl, vr) < -30000) {
-            vl += 30000, vr += 30000;
-            vl /= 2, vr /= 2;
-            vl -= 30000, vr -= 30000;
-            if (std::min(vl, vr) < -31000) {
-                vl += 31000, vr += 31000;
-                vl /= 2, vr /= 2;
-                vl -= 31000, vr -= 31000;
-                if (std::min(vl, vr) < -32000) {
-                    vl = std::max<int64_t>(vl, -32000ll);
-                    vr = std::max<int64_t>(vr, -32000ll);
-                    // std::cout << "clip lower" << std::endl;
-                }
-            }
+/*!
+ * Render a trace of accesses ordered by time into a WAV file, in blocks of the
+ * given size like the audio device requests them. The accesses of each block
+ * are spread over it like SoundCallback does, so the output matches live
+ * playback if the callback runs on time. Unlike live playback they go to the
+ * oscillators directly instead of through the access ring, hence none are
+ * dropped however many fall into one block. Returns the number of frames
+ * rendered, including the release of the last notes.
+ */
+size_t SoundRenderTrace(const std::vector<SoundEvent>& trace, size_t array_size,
+                        BlinkenAlgorithms::WavWriter& wav,
+                        size_t block = 1024) {
+    array_max = array_size;
+    // reset now instead of in the first callback, which would otherwise drop
+    // the accesses posted for the first block
+    s_sound_reset = false;
+    s_pos = 0;
+    s_mixer.clear();
+    s_access_ring.clear();
+
+    size_t end = 0;
+    if (!trace.empty())
+        end = trace.back().time + g_sound_sustain * s_samplerate;
+
+    std::vector<int16_t> buffer(2 * block);
+    size_t e = 0, frames = 0;
+    for (size_t p = 0; p < end; p += block) {
+        size_t b = e;
+        while (e < trace.size() && trace[e].time < p + block)
+            ++e;
+
+        // spread out accesses over the block, skipping black ones
+        float pscale = (float)block / (e - b);
+        for (size_t i = 0; b + i < e; ++i) {
+            if (trace[b + i].index != BlinkenSort::black)
+                SoundAddNote(trace[b + i].index, p + i * pscale);
         }
 
-        *data++ = vl, *data++ = vr;
+        SoundRenderBlock(buffer.data(), block);
+        wav.write(buffer.data(), block);
+        frames += block;
     }
-
-    total_maximum = std::max(total_maximum, this_maximum);
-
-    // std::cout << "this_maximum " << this_maximum
-    //           << " this_maximum " << this_maximum
-    //           << " total_maximum " << total_maximum
-    //           << " volume_factor " << volume_factor
-    //           << std::endl;
-
-    // if (this_maximum < 25000) {
-    //     volume_factor = volume_factor * 101 / 100;
-    // }
-    // else if (this_maximum < 30000) {
-    //     volume_factor = volume_factor * 101 / 100;
-    // }
-    // else if (this_maximum > 30000) {
-    //     volume_factor = volume_factor * 99 / 100;
-    // }
-    // else if (this_maximum > 36000) {
-    //     volume_factor = volume_factor * 99 / 100;
-    // }
-
-    // if (volume_factor < 10)
-    //     volume_factor = 10;
-
-    // advance sample timestamp
-    p += size;
+    return frames;
 }
 
 #endif // !BLINKENALGORITHMS_ANIMATION_SORTSOUND_HEADER
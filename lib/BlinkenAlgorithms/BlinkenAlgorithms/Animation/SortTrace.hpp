@@ -0,0 +1,322 @@
+/*******************************************************************************
+ * lib/BlinkenAlgorithms/BlinkenAlgorithms/Animation/SortTrace.hpp
+ *
+ * Record all accesses and comparisons of a sorting or hashing algorithm into a
+ * compact binary trace, which can be replayed later without running the
+ * algorithm.
+ *
+ * Copyright (C) 2018 Timo Bingmann <tb@panthema.net>
+ *
+ * All rights reserved. Published under the GNU General Public License v3.0
+ ******************************************************************************/
+
+#ifndef BLINKENALGORITHMS_ANIMATION_SORTTRACE_HEADER
+#define BLINKENALGORITHMS_ANIMATION_SORTTRACE_HEADER
+
+#include <BlinkenAlgorithms/Animation/Sort.hpp>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace BlinkenSort {
+
+/*!
+ * Trace format: the magic "BSTR", varint version, varint array size n, and n
+ * varint initial values, followed by the events. Each event starts with a
+ * byte:
+ *
+ *   bits 0-1: type, see SortTraceEvent::Type
+ *   bit 2/3:  first/second item is a temporary outside the array
+ *   bits 4-7: logical time delta 0..14, 15: varint delta follows
+ *
+ * followed by the items: for Access one item, for Comparison two, for Counter
+ * none. An item inside the array is encoded as zigzag varint delta of its
+ * index to the previously encoded index, then every item has its varint value.
+ *
+ * The logical time counts animation steps: it advances with each access with
+ * delay and each comparison, which are the events the animation flashes.
+ */
+struct SortTraceEvent {
+    enum Type : uint8_t {
+        Access = 0, AccessNoDelay = 1, Comparison = 2, Counter = 3
+    };
+
+    //! index of items outside the array
+    static const uint32_t temporary = uint32_t(-1);
+
+    Type type;
+    //! logical time of the event
+    uint64_t time;
+    //! index of one or two items, or temporary
+    uint32_t index[2];
+    //! values of the items
+    uint32_t value[2];
+};
+
+//! varint and zigzag encoding of the trace
+class SortTraceCoding
+{
+public:
+    static void put_varint(std::vector<uint8_t>& out, uint64_t v) {
+        while (v >= 0x80) {
+            out.push_back(static_cast<uint8_t>(v) | 0x80);
+            v >>= 7;
+        }
+        out.push_back(static_cast<uint8_t>(v));
+    }
+
+    static bool get_varint(const uint8_t*& p, const uint8_t* end, uint64_t& v) {
+        v = 0;
+        for (unsigned shift = 0; p < end && shift < 64; shift += 7) {
+            uint8_t b = *p++;
+            v |= static_cast<uint64_t>(b & 0x7F) << shift;
+            if (!(b & 0x80))
+                return true;
+        }
+        return false;
+    }
+
+    static uint64_t zigzag(int64_t v) {
+        return (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63);
+    }
+
+    static int64_t unzigzag(uint64_t v) {
+        return static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1);
+    }
+};
+
+/*!
+ * Hook recording all events of an item type into an in-memory trace. The
+ * recorder takes over the animation hook while it exists, and snapshots the
+ * array on construction, so fill the array first, without hooks.
+ */
+template <typename ItemType = Item>
+class SortTraceRecorder : public SortAnimationBaseT<ItemType>, SortTraceCoding
+{
+public:
+    using Hook = SortAnimationBaseT<ItemType>;
+
+    SortTraceRecorder()
+        : array_(SortArray<ItemType>()) {
+        Hook::hook = this;
+
+        data_ = { 'B', 'S', 'T', 'R' };
+        put_varint(data_, 1);
+        put_varint(data_, array_.size());
+        for (size_t i = 0; i < array_.size(); ++i)
+            put_varint(data_, array_[i].value_);
+    }
+
+    ~SortTraceRecorder() {
+        if (Hook::hook == this)
+            Hook::hook = nullptr;
+    }
+
+    void OnAccess(const ItemType* a, bool with_delay) override {
+        if (with_delay) {
+            put_header(SortTraceEvent::Access, 1, a, nullptr);
+            ++count_[SortTraceEvent::Access];
+        }
+        else {
+            put_header(SortTraceEvent::AccessNoDelay, 0, a, nullptr);
+            ++count_[SortTraceEvent::AccessNoDelay];
+        }
+        put_item(a);
+    }
+
+    void OnComparison(const ItemType* a, const ItemType* b) override {
+        put_header(SortTraceEvent::Comparison, 1, a, b);
+        put_item(a), put_item(b);
+        ++count_[SortTraceEvent::Comparison];
+    }
+
+    void IncrementCounter() override {
+        put_header(SortTraceEvent::Counter, 0, nullptr, nullptr);
+        ++count_[SortTraceEvent::Counter];
+    }
+
+    //! encoded trace
+    const std::vector<uint8_t>& data() const { return data_; }
+
+    //! number of events of a type
+    size_t count(SortTraceEvent::Type t) const { return count_[t]; }
+
+    //! total number of events
+    size_t events() const {
+        return count_[0] + count_[1] + count_[2] + count_[3];
+    }
+
+    //! write trace to a file
+    bool save(const char* path) const {
+        FILE* f = fopen(path, "wb");
+        if (!f)
+            return false;
+        bool ok = fwrite(data_.data(), 1, data_.size(), f) == data_.size();
+        return fclose(f) == 0 && ok;
+    }
+
+private:
+    //! array whose indexes are recorded
+    std::vector<ItemType>& array_;
+
+    //! encoded trace
+    std::vector<uint8_t> data_;
+
+    //! logical time of the previous event and of the current one
+    uint64_t time_last_ = 0, time_ = 0;
+
+    //! previously encoded index
+    int64_t index_last_ = 0;
+
+    //! number of events of each type
+    size_t count_[4] = { 0, 0, 0, 0 };
+
+    bool in_array(const ItemType* a) const {
+        return a >= array_.data() && a < array_.data() + array_.size();
+    }
+
+    void put_header(SortTraceEvent::Type type, unsigned step,
+                    const ItemType* a, const ItemType* b) {
+        time_ += step;
+        uint64_t delta = time_ - time_last_;
+        time_last_ = time_;
+
+        uint8_t h = type;
+        if (a && !in_array(a)) h |= 4;
+        if (b && !in_array(b)) h |= 8;
+        h |= (delta < 15 ? delta : 15) << 4;
+        data_.push_back(h);
+        if (delta >= 15)
+            put_varint(data_, delta);
+    }
+
+    void put_item(const ItemType* a) {
+        if (in_array(a)) {
+            int64_t index = a - array_.data();
+            put_varint(data_, zigzag(index - index_last_));
+            index_last_ = index;
+        }
+        put_varint(data_, a->value_);
+    }
+};
+
+/*!
+ * Decodes a trace from memory: the initial array, then event by event.
+ */
+class SortTraceReader : SortTraceCoding
+{
+public:
+    //! decoder state before an event, from which decoding can resume
+    struct Position {
+        size_t offset;
+        uint64_t event, time;
+        int64_t index_last;
+    };
+
+    //! parse header, check ok() afterwards
+    SortTraceReader(const uint8_t* data, size_t size)
+        : begin_(data), pos_(data), end_(data + size) {
+        uint64_t version, n;
+        if (size < 4 || memcmp(data, "BSTR", 4) != 0)
+            return;
+        pos_ += 4;
+        if (!get_varint(pos_, end_, version) || version != 1)
+            return;
+        // each value takes at least one byte, which bounds the allocation
+        if (!get_varint(pos_, end_, n) || n > size_t(end_ - pos_))
+            return;
+        initial_.resize(n);
+        for (size_t i = 0; i < n; ++i) {
+            uint64_t v;
+            if (!get_varint(pos_, end_, v))
+                return;
+            initial_[i] = v;
+        }
+        events_begin_ = pos_;
+        ok_ = true;
+    }
+
+    //! true if the header was valid
+    bool ok() const { return ok_; }
+
+    //! values of the array at the start of the trace
+    const std::vector<uint32_t>& initial() const { return initial_; }
+
+    //! decode next event, returns false at the end or on a corrupt trace.
+    bool next(SortTraceEvent& ev) {
+        if (!ok_ || pos_ >= end_)
+            return false;
+
+        uint8_t h = *pos_++;
+        ev.type = static_cast<SortTraceEvent::Type>(h & 3);
+
+        uint64_t delta = h >> 4;
+        if (delta == 15 && !get_varint(pos_, end_, delta))
+            return (ok_ = false);
+        time_ += delta;
+        ev.time = time_;
+        ++event_;
+
+        unsigned items = ev.type == SortTraceEvent::Comparison ? 2
+                         : ev.type == SortTraceEvent::Counter ? 0 : 1;
+        for (unsigned k = 0; k < 2; ++k) {
+            ev.index[k] = ev.value[k] = SortTraceEvent::temporary;
+            if (k >= items)
+                continue;
+            uint64_t v;
+            if (!(h & (4 << k))) {
+                if (!get_varint(pos_, end_, v))
+                    return (ok_ = false);
+                index_last_ += unzigzag(v);
+                ev.index[k] = index_last_;
+            }
+            if (!get_varint(pos_, end_, v))
+                return (ok_ = false);
+            ev.value[k] = v;
+        }
+        return true;
+    }
+
+    //! restart at the first event
+    void rewind() {
+        pos_ = events_begin_;
+        event_ = time_ = 0;
+        index_last_ = 0;
+    }
+
+    //! number of events decoded since the first one
+    uint64_t event() const { return event_; }
+
+    //! current decoder state
+    Position position() const {
+        return Position {
+                   static_cast<size_t>(pos_ - begin_), event_, time_, index_last_
+        };
+    }
+
+    //! resume decoding at a position taken from the same trace
+    void seek(const Position& p) {
+        pos_ = begin_ + p.offset;
+        event_ = p.event;
+        time_ = p.time;
+        index_last_ = p.index_last;
+    }
+
+private:
+    const uint8_t* begin_, * pos_, * end_;
+    const uint8_t* events_begin_ = nullptr;
+    bool ok_ = false;
+
+    std::vector<uint32_t> initial_;
+
+    uint64_t event_ = 0, time_ = 0;
+    int64_t index_last_ = 0;
+};
+
+} // namespace BlinkenSort
+
+#endif // !BLINKENALGORITHMS_ANIMATION_SORTTRACE_HEADER
+
+/******************************************************************************/
@@ -34,6 +34,11 @@ static inline
 uint32_t random(uint32_t begin, uint32_t limit) {
     return ::random() % (limit - begin) + begin;
 }
+
+static inline
+void randomSeed(uint32_t seed) {
+    ::srandom(seed);
+}
 #endif
 
 #if !ESP8266 && !TEENSYDUINO
@@ -44,6 +49,17 @@ unsigned long millis() {
 }
 #endif
 
+/******************************************************************************/
+// Thread-local State
+
+//! storage of per-animation globals like the animated array and the hook: on
+//! the Pi several animations may run side by side on separate threads.
+#if ESP8266 || TEENSYDUINO
+#define BLINKEN_THREAD_LOCAL
+#else
+#define BLINKEN_THREAD_LOCAL thread_local
+#endif
+
 /******************************************************************************/
 // Timing, Delay, and Control Methods
 
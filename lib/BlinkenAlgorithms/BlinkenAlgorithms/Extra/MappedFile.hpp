@@ -0,0 +1,91 @@
+/*******************************************************************************
+ * lib/BlinkenAlgorithms/BlinkenAlgorithms/Extra/MappedFile.hpp
+ *
+ * Copyright (C) 2018 Timo Bingmann <tb@panthema.net>
+ *
+ * All rights reserved. Published under the GNU General Public License v3.0
+ ******************************************************************************/
+
+#ifndef BLINKENALGORITHMS_EXTRA_MAPPEDFILE_HEADER
+#define BLINKENALGORITHMS_EXTRA_MAPPEDFILE_HEADER
+
+#include <cstdint>
+#include <cstdio>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace BlinkenAlgorithms {
+
+/*!
+ * Read-only memory mapping of a whole file. The pages are loaded on demand by
+ * the kernel, hence even large files are available immediately and are never
+ * copied into the heap.
+ */
+class MappedFile
+{
+public:
+    explicit MappedFile(const char* path) {
+        int fd = open(path, O_RDONLY);
+        if (fd < 0) {
+            fprintf(stderr, "MappedFile: could not open %s\n", path);
+            return;
+        }
+
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            fprintf(stderr, "MappedFile: could not stat %s\n", path);
+            ::close(fd);
+            return;
+        }
+
+        size_ = st.st_size;
+        if (size_ != 0) {
+            void* p = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p == MAP_FAILED) {
+                fprintf(stderr, "MappedFile: could not map %s\n", path);
+                size_ = 0;
+            }
+            else {
+                data_ = static_cast<const uint8_t*>(p);
+                // the file is mostly read front to back
+                madvise(p, size_, MADV_SEQUENTIAL);
+            }
+        }
+        ::close(fd);
+    }
+
+    ~MappedFile() {
+        close();
+    }
+
+    //! non-copyable: owns the mapping
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator = (const MappedFile&) = delete;
+
+    //! true if the file was mapped
+    bool ok() const { return data_ != nullptr; }
+
+    const uint8_t* data() const { return data_; }
+    size_t size() const { return size_; }
+
+    //! unmap the file
+    void close() {
+        if (data_)
+            munmap(const_cast<uint8_t*>(data_), size_);
+        data_ = nullptr;
+        size_ = 0;
+    }
+
+private:
+    const uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+} // namespace BlinkenAlgorithms
+
+#endif // !BLINKENALGORITHMS_EXTRA_MAPPEDFILE_HEADER
+
+/******************************************************************************/
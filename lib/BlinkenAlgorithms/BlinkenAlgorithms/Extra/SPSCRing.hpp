@@ -0,0 +1,90 @@
+/*******************************************************************************
+ * lib/BlinkenAlgorithms/BlinkenAlgorithms/Extra/SPSCRing.hpp
+ *
+ * Copyright (C) 2018 Timo Bingmann <tb@panthema.net>
+ *
+ * All rights reserved. Published under the GNU General Public License v3.0
+ ******************************************************************************/
+
+#ifndef BLINKENALGORITHMS_EXTRA_SPSCRING_HEADER
+#define BLINKENALGORITHMS_EXTRA_SPSCRING_HEADER
+
+#include <atomic>
+#include <cstddef>
+
+namespace BlinkenAlgorithms {
+
+/*!
+ * Bounded lock-free ring buffer for exactly one producer and one consumer
+ * thread. Neither side ever blocks: push() fails when the ring is full and
+ * pop() fails when it is empty. Capacity must be a power of two.
+ */
+template <typename Type, size_t Capacity>
+class SPSCRing
+{
+    static_assert((Capacity & (Capacity - 1)) == 0,
+                  "Capacity must be a power of two");
+
+public:
+    //! append an item (producer only), returns false if the ring is full.
+    bool push(const Type& t) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_cache_ == Capacity) {
+            head_cache_ = head_.load(std::memory_order_acquire);
+            if (tail - head_cache_ == Capacity)
+                return false;
+        }
+        items_[tail & (Capacity - 1)] = t;
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    //! remove the oldest item (consumer only), returns false if empty.
+    bool pop(Type& t) {
+        size_t head = head_.load(std::memory_order_relaxed);
+        if (head == tail_cache_) {
+            tail_cache_ = tail_.load(std::memory_order_acquire);
+            if (head == tail_cache_)
+                return false;
+        }
+        t = items_[head & (Capacity - 1)];
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    //! number of items available to the consumer (consumer only)
+    size_t size() {
+        tail_cache_ = tail_.load(std::memory_order_acquire);
+        return tail_cache_ - head_.load(std::memory_order_relaxed);
+    }
+
+    //! discard all available items (consumer only)
+    void clear() {
+        // refresh tail_cache_ too: if it lagged behind the new head_, pop()
+        // would see head != tail_cache_ and read past the producer.
+        tail_cache_ = tail_.load(std::memory_order_acquire);
+        head_.store(tail_cache_, std::memory_order_release);
+    }
+
+    static constexpr size_t capacity() { return Capacity; }
+
+private:
+    //! items in the ring
+    Type items_[Capacity];
+
+    //! next position to read, written by the consumer
+    alignas(64) std::atomic<size_t> head_ { 0 };
+    //! consumer's copy of tail_
+    size_t tail_cache_ = 0;
+
+    //! next position to write, written by the producer
+    alignas(64) std::atomic<size_t> tail_ { 0 };
+    //! producer's copy of head_
+    size_t head_cache_ = 0;
+};
+
+} // namespace BlinkenAlgorithms
+
+#endif // !BLINKENALGORITHMS_EXTRA_SPSCRING_HEADER
+
+/******************************************************************************/
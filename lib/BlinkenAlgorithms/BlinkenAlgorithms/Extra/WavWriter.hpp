@@ -0,0 +1,106 @@
+/*******************************************************************************
+ * lib/BlinkenAlgorithms/BlinkenAlgorithms/Extra/WavWriter.hpp
+ *
+ * Copyright (C) 2018 Timo Bingmann <tb@panthema.net>
+ *
+ * All rights reserved. Published under the GNU General Public License v3.0
+ ******************************************************************************/
+
+#ifndef BLINKENALGORITHMS_EXTRA_WAVWRITER_HEADER
+#define BLINKENALGORITHMS_EXTRA_WAVWRITER_HEADER
+
+#include <cstdint>
+#include <cstdio>
+
+namespace BlinkenAlgorithms {
+
+/*!
+ * Writes interleaved 16-bit PCM samples into a RIFF WAV file. The header is
+ * written first with zero sizes, which are filled in by close().
+ */
+class WavWriter
+{
+public:
+    WavWriter(const char* path, uint32_t samplerate, uint16_t channels)
+        : channels_(channels) {
+        file_ = fopen(path, "wb");
+        if (!file_) {
+            fprintf(stderr, "WavWriter: could not open %s\n", path);
+            return;
+        }
+
+        uint16_t block_align = channels * sizeof(int16_t);
+
+        fwrite("RIFF", 1, 4, file_);
+        write32(0);                         // RIFF size, set by close()
+        fwrite("WAVEfmt ", 1, 8, file_);
+        write32(16);                        // fmt chunk size
+        write16(1);                         // PCM
+        write16(channels);
+        write32(samplerate);
+        write32(samplerate * block_align);  // byte rate
+        write16(block_align);
+        write16(16);                        // bits per sample
+        fwrite("data", 1, 4, file_);
+        write32(0);                         // data size, set by close()
+    }
+
+    ~WavWriter() {
+        close();
+    }
+
+    //! non-copyable: owns the file
+    WavWriter(const WavWriter&) = delete;
+    WavWriter& operator = (const WavWriter&) = delete;
+
+    //! true if the file was opened
+    bool ok() const { return file_ != nullptr; }
+
+    //! write frames of interleaved samples, one per channel.
+    void write(const int16_t* samples, size_t frames) {
+        if (!file_)
+            return;
+        for (size_t i = 0; i < frames * channels_; ++i)
+            write16(static_cast<uint16_t>(samples[i]));
+        frames_ += frames;
+    }
+
+    //! number of frames written
+    size_t frames() const { return frames_; }
+
+    //! fill in chunk sizes and close the file
+    void close() {
+        if (!file_)
+            return;
+
+        uint32_t data_size = frames_ * channels_ * sizeof(int16_t);
+        fseek(file_, 4, SEEK_SET);
+        write32(36 + data_size);
+        fseek(file_, 40, SEEK_SET);
+        write32(data_size);
+
+        fclose(file_);
+        file_ = nullptr;
+    }
+
+private:
+    FILE* file_ = nullptr;
+    uint16_t channels_;
+    size_t frames_ = 0;
+
+    //! write little-endian integers regardless of host byte order
+    void write16(uint16_t v) {
+        putc(v & 0xFF, file_);
+        putc(v >> 8, file_);
+    }
+    void write32(uint32_t v) {
+        write16(v & 0xFFFF);
+        write16(v >> 16);
+    }
+};
+
+} // namespace BlinkenAlgorithms
+
+#endif // !BLINKENALGORITHMS_EXTRA_WAVWRITER_HEADER
+
+/******************************************************************************/
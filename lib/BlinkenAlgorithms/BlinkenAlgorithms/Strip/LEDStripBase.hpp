@@ -28,7 +28,7 @@ public:
         intensity_ = intensity;
     }
 
-    uint8_t gamma8(uint8_t v) const {
+    static uint8_t gamma8(uint8_t v) {
         static const uint8_t s_gamma8[256] = {
             0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
             0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1,
@@ -0,0 +1,156 @@
+/*******************************************************************************
+ * lib/BlinkenAlgorithms/BlinkenAlgorithms/Strip/MemoryStrip.hpp
+ *
+ * Headless LED strip which keeps all pixels in a plain buffer and records each
+ * show() into a ring of captured frames. Used to run and measure animations on
+ * a build machine without any LED hardware attached.
+ *
+ * Copyright (C) 2018 Timo Bingmann <tb@panthema.net>
+ *
+ * All rights reserved. Published under the GNU General Public License v3.0
+ ******************************************************************************/
+
+#ifndef BLINKENALGORITHMS_STRIP_MEMORYSTRIP_HEADER
+#define BLINKENALGORITHMS_STRIP_MEMORYSTRIP_HEADER
+
+#include <BlinkenAlgorithms/Color.hpp>
+#include <BlinkenAlgorithms/Control.hpp>
+#include <BlinkenAlgorithms/Strip/LEDStripBase.hpp>
+
+#include <algorithm>
+#include <vector>
+
+namespace BlinkenAlgorithms {
+
+class MemoryStrip : public LEDStripBase
+{
+public:
+    //! construct strip with strip_size pixels, keeping the last frame_capacity
+    //! frames shown. With frame_capacity = 0 show() only counts frames.
+    explicit MemoryStrip(size_t strip_size, size_t frame_capacity = 0)
+        : strip_size_(strip_size),
+          strip_data_(strip_size, Color(0)),
+          frame_capacity_(frame_capacity),
+          frame_data_(strip_size * frame_capacity),
+          frame_ts_(frame_capacity) { }
+
+    size_t size() const { return strip_size_; }
+
+    void setPixel(size_t i, const Color& c) {
+        if (i < strip_size_)
+            strip_data_[i] = c;
+    }
+
+    Color getPixel(size_t i) const {
+        return i < strip_size_ ? strip_data_[i] : Color(0);
+    }
+
+    void orPixel(size_t i, const Color& c) {
+        if (i < strip_size_)
+            strip_data_[i] = strip_data_[i] | c;
+    }
+
+    void addPixel(size_t i, const Color& c) {
+        if (i < strip_size_)
+            strip_data_[i] = strip_data_[i] + c;
+    }
+
+    bool busy() const { return false; }
+
+    void show() {
+        unsigned long ts = micros();
+        if (frames_shown_ == 0)
+            ts_first_ = ts;
+        ts_last_ = ts;
+        ++frames_shown_;
+
+        if (frame_capacity_ == 0)
+            return;
+
+        // overwrite the oldest frame in the ring
+        std::copy(strip_data_.begin(), strip_data_.end(),
+                  frame_data_.begin() + frame_pos_ * strip_size_);
+        frame_ts_[frame_pos_] = ts;
+        frame_pos_ = (frame_pos_ + 1) % frame_capacity_;
+    }
+
+    //! direct access to the current (unshown) pixel buffer
+    const Color* data() const { return strip_data_.data(); }
+
+    // *** Captured Frames
+
+    //! number of show() calls since construction or clear_frames()
+    size_t frames_shown() const { return frames_shown_; }
+
+    //! number of frames currently held in the ring
+    size_t frames_stored() const {
+        return std::min(frames_shown_, frame_capacity_);
+    }
+
+    //! pixels of stored frame f, f = 0 is the oldest stored frame.
+    const Color* frame(size_t f) const {
+        return frame_data_.data() + frame_index(f) * strip_size_;
+    }
+
+    //! timestamp in microseconds of stored frame f
+    unsigned long frame_timestamp(size_t f) const {
+        return frame_ts_[frame_index(f)];
+    }
+
+    //! microseconds between first and last show()
+    unsigned long elapsed_micros() const {
+        return ts_last_ - ts_first_;
+    }
+
+    //! average frame rate over all frames shown
+    double frames_per_second() const {
+        if (frames_shown_ < 2 || ts_last_ == ts_first_)
+            return 0;
+        return (frames_shown_ - 1) * 1e6 / (ts_last_ - ts_first_);
+    }
+
+    //! reset frame counters and drop all captured frames
+    void clear_frames() {
+        frames_shown_ = 0;
+        frame_pos_ = 0;
+        ts_first_ = ts_last_ = 0;
+    }
+
+private:
+    //! strip length
+    size_t strip_size_;
+
+    //! current pixel colors
+    std::vector<Color> strip_data_;
+
+    //! number of frames kept in the ring
+    size_t frame_capacity_;
+
+    //! ring of captured frames, frame_capacity_ * strip_size_ pixels
+    std::vector<Color> frame_data_;
+
+    //! timestamps of captured frames
+    std::vector<unsigned long> frame_ts_;
+
+    //! next ring slot to overwrite
+    size_t frame_pos_ = 0;
+
+    //! total number of frames shown
+    size_t frames_shown_ = 0;
+
+    //! timestamps of first and last show()
+    unsigned long ts_first_ = 0, ts_last_ = 0;
+
+    //! map stored frame number to ring slot
+    size_t frame_index(size_t f) const {
+        if (frames_shown_ < frame_capacity_)
+            return f;
+        return (frame_pos_ + f) % frame_capacity_;
+    }
+};
+
+} // namespace BlinkenAlgorithms
+
+#endif // !BLINKENALGORITHMS_STRIP_MEMORYSTRIP_HEADER
+
+/******************************************************************************/
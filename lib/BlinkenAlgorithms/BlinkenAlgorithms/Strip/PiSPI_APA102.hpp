@@ -13,9 +13,16 @@
 #include <BlinkenAlgorithms/Extra/PiGPIO.hpp>
 #include <BlinkenAlgorithms/Strip/LEDStripBase.hpp>
 
+#include <algorithm>
+#include <atomic>
 #include <cerrno>
+#include <condition_variable>
+#include <cstdio>
 #include <cstring>
+#include <functional>
 #include <iostream>
+#include <mutex>
+#include <thread>
 #include <vector>
 
 #include <asm/ioctl.h>
@@ -24,12 +31,88 @@
 
 namespace BlinkenAlgorithms {
 
+//! APA102 pixel in wire format: 0b111 + 5-bit brightness, blue, green, red
+struct APA102Color {
+    uint8_t w = 0, b = 0, g = 0, r = 0;
+};
+
+/*!
+ * Converts a buffer of Colors into APA102 wire format. RGBW is gamma corrected
+ * and folded into RGB, which is then split into the 5-bit global brightness
+ * and 8-bit RGB values. The gamma curve, the brightness of each channel
+ * maximum, and the reciprocals replacing the three divisions are precomputed,
+ * so the conversion contains only table lookups, multiplications and shifts.
+ */
+class APA102Converter
+{
+public:
+    APA102Converter() {
+        for (unsigned v = 0; v < 256; ++v)
+            gamma_[v] = LEDStripBase::gamma8(v);
+        // channel values r + w range up to 2 * 255
+        for (unsigned v = 0; v < 511; ++v)
+            bright_[v] = (((v + 1) * 0x1F - 1) >> 8) + 1;
+        // exact for all numerators 0x1F * 510 + m / 2 < 2^14.
+        for (unsigned m = 1; m < 64; ++m)
+            recip_[m] = ((1u << 24) + m - 1) / m;
+        recip_[0] = 0;
+    }
+
+    void convert(const Color* in, size_t n, APA102Color* out) const {
+        // work in blocks: first gather table lookups into small arrays, then
+        // run the arithmetic in a separate loop which the compiler vectorizes.
+        static const size_t block = 256;
+        uint16_t r[block], g[block], b[block];
+        uint32_t m[block];
+
+        for (size_t s = 0; s < n; s += block) {
+            size_t e = std::min(block, n - s);
+            const Color* c = in + s;
+            APA102Color* o = out + s;
+
+            for (size_t i = 0; i < e; ++i) {
+                // combine RGBW to RGB
+                unsigned w = gamma_[c[i].w];
+                r[i] = gamma_[c[i].r] + w;
+                g[i] = gamma_[c[i].g] + w;
+                b[i] = gamma_[c[i].b] + w;
+                m[i] = bright_[std::max(std::max(r[i], g[i]), b[i])];
+            }
+
+            for (size_t i = 0; i < e; ++i) {
+                // transform color to RGB + brightness
+                uint32_t rm = recip_[m[i]], h = m[i] >> 1;
+                uint32_t vr = (uint64_t(0x1F * r[i] + h) * rm) >> 24;
+                uint32_t vg = (uint64_t(0x1F * g[i] + h) * rm) >> 24;
+                uint32_t vb = (uint64_t(0x1F * b[i] + h) * rm) >> 24;
+                o[i].r = std::min(vr, 255u);
+                o[i].g = std::min(vg, 255u);
+                o[i].b = std::min(vb, 255u);
+                o[i].w = 0b11100000 | std::min(m[i], 31u);
+            }
+        }
+    }
+
+private:
+    //! gamma correction
+    uint8_t gamma_[256];
+    //! brightness of channel maximum, 1..62
+    uint8_t bright_[511];
+    //! ceil(2^24 / m)
+    uint32_t recip_[64];
+};
+
 class PiSPI_APA102 : public LEDStripBase
 {
 public:
+    //! function submitting one SPI_IOC_MESSAGE with count transfers. The
+    //! default calls ioctl() on the spidev device, a replacement can record the
+    //! transfers to test the strip without hardware.
+    using SPIMessageFunction =
+        std::function<int(struct spi_ioc_transfer* xfer, unsigned count)>;
+
     PiSPI_APA102(std::string path, size_t strip_size, int cs_pin = -1)
-        : strip_size_(strip_size),
-          strip_data_(strip_size) {
+        : PiSPI_APA102(strip_size) {
 
         fd_ = open(path.c_str(), O_RDWR);
         if (fd_ < 0) {
@@ -49,7 +132,6 @@ public:
                       << strerror(errno) << std::endl;
         }
 
-        spiSpeed_ = 13000000;
         if (ioctl(fd_, SPI_IOC_WR_MAX_SPEED_HZ, &spiSpeed_) < 0) {
             std::cerr << "SPI Speed Change failure: "
                       << strerror(errno) << std::endl;
@@ -57,114 +139,181 @@ public:
 
         cs_gpio_.set_pin(cs_pin, /* output */ true);
         cs_gpio_.write(0);
+
+        spi_message_ = [this](struct spi_ioc_transfer* xfer, unsigned count) {
+                           return ioctl(fd_, SPI_IOC_MESSAGE(count), xfer);
+                       };
+        setup_transfers(read_spidev_bufsiz());
     }
 
-    struct APAColor {
-        uint8_t w = 0, b = 0, g = 0, r = 0;
-    };
+    //! construct strip without device, sending frames to spi_message in
+    //! messages of at most max_message bytes.
+    PiSPI_APA102(size_t strip_size, SPIMessageFunction spi_message,
+                 size_t max_message = 4096)
+        : PiSPI_APA102(strip_size) {
+        spi_message_ = spi_message;
+        setup_transfers(max_message);
+    }
+
+    using APAColor = APA102Color;
 
     void setPixel(size_t index, const Color& color) {
-        if (index < strip_size_) {
-            // combine RGBW to RGB
-            unsigned r = gamma8(color.r), g = gamma8(color.g), b = gamma8(color.b);
-            r += gamma8(color.w), g += gamma8(color.w), b += gamma8(color.w);
-            // try to transform color to RGB + brightness
-            const uint16_t mm = 0x1F;
-            unsigned m = (((std::max(std::max(r, g), b) + 1) * mm - 1) >> 8) + 1;
-            r = (mm * r + (m >> 1)) / m;
-            g = (mm * g + (m >> 1)) / m;
-            b = (mm * b + (m >> 1)) / m;
-            r = r > 255 ? 255 : r, g = g > 255 ? 255 : g;
-            b = b > 255 ? 255 : b, m = m > 31 ? 31 : m;
-            strip_data_[index].r = r;
-            strip_data_[index].g = g;
-            strip_data_[index].b = b;
-            strip_data_[index].w = 0b11100000 | (0b00011111 & m);
-        }
+        if (index < strip_size_)
+            pixels_[index] = color;
+    }
+
+    Color getPixel(size_t index) const {
+        return index < strip_size_ ? pixels_[index] : Color(0);
     }
 
     void orPixel(size_t index, const Color& color) {
-        if (index < strip_size_) {
-            // combine RGBW to RGB
-            unsigned r = gamma8(color.r), g = gamma8(color.g), b = gamma8(color.b);
-            r += gamma8(color.w), g += gamma8(color.w), b += gamma8(color.w);
-            // try to transform color to RGB + brightness
-            const uint16_t mm = 0x1F;
-            unsigned m = (((std::max(std::max(r, g), b) + 1) * mm - 1) >> 8) + 1;
-            r = (mm * r + (m >> 1)) / m;
-            g = (mm * g + (m >> 1)) / m;
-            b = (mm * b + (m >> 1)) / m;
-            r = r > 255 ? 255 : r, g = g > 255 ? 255 : g;
-            b = b > 255 ? 255 : b, m = m > 31 ? 31 : m;
-            strip_data_[index].r |= r;
-            strip_data_[index].g |= g;
-            strip_data_[index].b |= b;
-            strip_data_[index].w |= 0b11100000 | (0b00011111 & m);
-        }
+        if (index < strip_size_)
+            pixels_[index] = pixels_[index] | color;
     }
 
     void addPixel(size_t index, const Color& color) {
-        if (index < strip_size_) {
-            // combine RGBW to RGB
-            unsigned r = gamma8(color.r), g = gamma8(color.g), b = gamma8(color.b);
-            r += gamma8(color.w), g += gamma8(color.w), b += gamma8(color.w);
-            // try to transform color to RGB + brightness
-            const uint16_t mm = 0x1F;
-            unsigned m = (((std::max(std::max(r, g), b) + 1) * mm - 1) >> 8) + 1;
-            r = (mm * r + (m >> 1)) / m;
-            g = (mm * g + (m >> 1)) / m;
-            b = (mm * b + (m >> 1)) / m;
-            r = r > 255 ? 255 : r, g = g > 255 ? 255 : g;
-            b = b > 255 ? 255 : b, m = m > 31 ? 31 : m;
-            strip_data_[index].r =
-                std::min(255, static_cast<uint16_t>(r) + strip_data_[index].r);
-            strip_data_[index].g =
-                std::min(255, static_cast<uint16_t>(g) + strip_data_[index].g);
-            strip_data_[index].b =
-                std::min(255, static_cast<uint16_t>(b) + strip_data_[index].b);
-            strip_data_[index].w =
-                0b11100000 | std::min(
-                    31u, (0b00011111 & m) + (0b00011111 & strip_data_[index].w));
-        }
+        if (index < strip_size_)
+            pixels_[index] = pixels_[index] + color;
     }
 
-    bool busy() const { return false; }
+    ~PiSPI_APA102() {
+        set_async(false);
+        if (fd_ >= 0)
+            close(fd_);
+    }
 
-    void show() {
-        uint8_t buf_start[4] = { 0x00, 0x00, 0x00, 0x00 };
-        SPIwrite(buf_start, 4);
+    //! true while a frame is being transmitted in asynchronous mode
+    bool busy() const { return in_flight_; }
 
-        SPIwrite(reinterpret_cast<uint8_t*>(strip_data_.data()),
-                 4 * strip_size_);
+    //! Enable or disable asynchronous mode. In asynchronous mode show() only
+    //! converts the frame into the back buffer and hands it to a background
+    //! thread for transmission, while the caller continues with the next one.
+    void set_async(bool async) {
+        if (async == async_)
+            return;
 
-        buf_start[0] = 0xFF;
-        for (size_t i = 0; i < (strip_size_ / 2 + 7) / 8; ++i) {
-            SPIwrite(buf_start, 1);
+        if (async) {
+            stop_ = false;
+            async_ = true;
+            thread_ = std::thread([this]() { transmit_loop(); });
+        }
+        else {
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                stop_ = true;
+            }
+            cv_.notify_all();
+            thread_.join();
+            async_ = false;
         }
     }
 
+    void show() {
+        if (!async_) {
+            converter_.convert(pixels_.data(), strip_size_, strip_data(front_));
+            transmit(front_);
+            return;
+        }
+
+        // convert into back buffer while the front may still be in flight
+        size_t back = 1 - front_;
+        converter_.convert(pixels_.data(), strip_size_, strip_data(back));
+
+        // wait for the previous frame, then swap buffers
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [this]() { return !in_flight_; });
+        front_ = back;
+        in_flight_ = true;
+        lock.unlock();
+        cv_.notify_all();
+    }
+
     size_t size() const { return strip_size_; }
 
+    //! raw APA102 frame last shown: start frame, pixel data, and end frame
+    const std::vector<uint8_t>& frame() const { return frame_[front_]; }
+
 protected:
-    int SPIwrite(unsigned char* data, int len) {
+    //! common initialization of frame buffers
+    explicit PiSPI_APA102(size_t strip_size)
+        : strip_size_(strip_size),
+          fd_(-1),
+          spiSpeed_(13000000),
+          pixels_(strip_size, Color(0)) {
+        for (size_t f = 0; f < 2; ++f) {
+            // start frame: 32 zero bits, end frame: at least n/2 one bits to
+            // clock the data through the whole strip.
+            frame_[f].resize(4 + 4 * strip_size + (strip_size / 2 + 7) / 8);
+            std::fill(frame_[f].begin(), frame_[f].begin() + 4, 0x00);
+            std::fill(frame_[f].begin() + 4 + 4 * strip_size_,
+                      frame_[f].end(), 0xFF);
+            converter_.convert(pixels_.data(), strip_size_, strip_data(f));
+        }
+    }
 
-        cs_gpio_.write(1);
+    //! read maximum message size spidev accepts
+    static size_t read_spidev_bufsiz() {
+        size_t bufsiz = 4096;
+        FILE* f = fopen("/sys/module/spidev/parameters/bufsiz", "r");
+        if (f) {
+            if (fscanf(f, "%zu", &bufsiz) != 1 || bufsiz == 0)
+                bufsiz = 4096;
+            fclose(f);
+        }
+        return bufsiz;
+    }
 
-        struct spi_ioc_transfer spi;
-        memset(&spi, 0, sizeof(spi));
+    //! split frame buffers into transfers of at most max_message bytes
+    void setup_transfers(size_t max_message) {
+        for (size_t f = 0; f < 2; ++f) {
+            transfers_[f].clear();
+            for (size_t pos = 0; pos < frame_[f].size(); pos += max_message) {
+                struct spi_ioc_transfer spi;
+                memset(&spi, 0, sizeof(spi));
+
+                spi.tx_buf = (unsigned long)(frame_[f].data() + pos);
+                spi.rx_buf = 0x0;
+                spi.len = std::min(max_message, frame_[f].size() - pos);
+                spi.delay_usecs = 0;
+                spi.speed_hz = spiSpeed_;
+                spi.bits_per_word = 8;
+
+                transfers_[f].push_back(spi);
+            }
+        }
+    }
+
+    //! pixel data inside frame buffer f
+    APAColor* strip_data(size_t f) {
+        return reinterpret_cast<APAColor*>(frame_[f].data() + 4);
+    }
 
-        spi.tx_buf = (unsigned long)data;
-        spi.rx_buf = 0x0;
-        spi.len = len;
-        spi.delay_usecs = 0;
-        spi.speed_hz = spiSpeed_;
-        spi.bits_per_word = 8;
+    //! send frame buffer f, the whole frame is usually one message.
+    void transmit(size_t f) {
+        cs_gpio_.write(1);
 
-        int x = ioctl(fd_, SPI_IOC_MESSAGE(1), &spi);
+        for (struct spi_ioc_transfer& xfer : transfers_[f])
+            spi_message_(&xfer, 1);
 
         cs_gpio_.write(1);
+    }
 
-        return x;
+    //! background thread in asynchronous mode
+    void transmit_loop() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true) {
+            cv_.wait(lock, [this]() { return in_flight_ || stop_; });
+            if (!in_flight_)
+                break;
+
+            size_t f = front_;
+            lock.unlock();
+            transmit(f);
+            lock.lock();
+
+            in_flight_ = false;
+            cv_.notify_all();
+        }
     }
 
 private:
@@ -180,8 +329,41 @@ private:
     //! GPIO CS Pin for SPI multiplex
     GPIOPin cs_gpio_;
 
-    //! strip color data
-    std::vector<APAColor> strip_data_;
+    //! strip colors as set, converted to wire format in show()
+    std::vector<Color> pixels_;
+
+    //! front and back frame buffers sent to the strip
+    std::vector<uint8_t> frame_[2];
+
+    //! frame buffer last shown (and in flight in asynchronous mode)
+    size_t front_ = 0;
+
+    //! color conversion tables
+    APA102Converter converter_;
+
+    //! pre-assembled transfers covering each frame buffer
+    std::vector<struct spi_ioc_transfer> transfers_[2];
+
+    //! submits SPI messages
+    SPIMessageFunction spi_message_;
+
+    //! asynchronous mode enabled
+    bool async_ = false;
+
+    //! background transmit thread
+    std::thread thread_;
+
+    //! protects front_, in_flight_, and stop_ in asynchronous mode
+    std::mutex mutex_;
+
+    //! signals new frames and finished transmissions
+    std::condition_variable cv_;
+
+    //! a frame is handed to or being sent by the background thread
+    std::atomic<bool> in_flight_ { false };
+
+    //! terminate background thread
+    bool stop_ = false;
 };
 
 } // namespace BlinkenAlgorithms
@@ -0,0 +1,267 @@
+/*******************************************************************************
+ * lib/BlinkenAlgorithms/BlinkenAlgorithms/Strip/SegmentStrip.hpp
+ *
+ * Split one LED strip into segments which are drawn independently, usually by
+ * separate threads, and composed into one show() of the strip per frame.
+ *
+ * Copyright (C) 2018 Timo Bingmann <tb@panthema.net>
+ *
+ * All rights reserved. Published under the GNU General Public License v3.0
+ ******************************************************************************/
+
+#ifndef BLINKENALGORITHMS_STRIP_SEGMENTSTRIP_HEADER
+#define BLINKENALGORITHMS_STRIP_SEGMENTSTRIP_HEADER
+
+#include <BlinkenAlgorithms/Color.hpp>
+#include <BlinkenAlgorithms/Control.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace BlinkenAlgorithms {
+
+template <typename BaseStrip>
+class StripCompositor;
+
+/*!
+ * Window [offset, offset + size) of a base strip owned by a StripCompositor.
+ * Pixels are drawn into a private buffer without locking, and show() commits
+ * the pixels changed since the last show() to the base strip.
+ */
+template <typename BaseStrip>
+class SegmentStrip
+{
+public:
+    SegmentStrip(StripCompositor<BaseStrip>& compositor,
+                 size_t offset, size_t size)
+        : compositor_(compositor), offset_(offset),
+          pixels_(size, Color(0)), dirty_begin_(0), dirty_end_(size) { }
+
+    size_t size() const { return pixels_.size(); }
+
+    //! first pixel of the segment on the base strip
+    size_t offset() const { return offset_; }
+
+    void setPixel(size_t i, const Color& c) {
+        if (i < pixels_.size()) {
+            pixels_[i] = c;
+            mark_dirty(i);
+        }
+    }
+
+    Color getPixel(size_t i) const {
+        return i < pixels_.size() ? pixels_[i] : Color(0);
+    }
+
+    void orPixel(size_t i, const Color& c) {
+        if (i < pixels_.size()) {
+            pixels_[i] = pixels_[i] | c;
+            mark_dirty(i);
+        }
+    }
+
+    void addPixel(size_t i, const Color& c) {
+        if (i < pixels_.size()) {
+            pixels_[i] = pixels_[i] + c;
+            mark_dirty(i);
+        }
+    }
+
+    //! segments never wait for the base strip, the compositor does.
+    bool busy() const { return false; }
+
+    uint8_t intensity() const {
+        return compositor_.base().intensity();
+    }
+    void set_intensity(uint8_t intensity) {
+        compositor_.base().set_intensity(intensity);
+    }
+
+    void show() {
+        compositor_.commit(*this);
+    }
+
+private:
+    StripCompositor<BaseStrip>& compositor_;
+
+    //! first pixel on the base strip
+    size_t offset_;
+
+    //! pixels drawn by the segment's thread
+    std::vector<Color> pixels_;
+
+    //! range of pixels changed since the last commit
+    size_t dirty_begin_, dirty_end_;
+
+    void mark_dirty(size_t i) {
+        dirty_begin_ = std::min(dirty_begin_, i);
+        dirty_end_ = std::max(dirty_end_, i + 1);
+    }
+
+    friend class StripCompositor<BaseStrip>;
+};
+
+/*!
+ * Owns the segments of a base strip. Without start(), each commit of a segment
+ * shows the base strip directly. After start(), a background thread shows the
+ * base strip at up to fps frames per second whenever segments committed since
+ * the last frame, such that segments animated by several threads are composed
+ * into one show() per frame.
+ */
+template <typename BaseStrip>
+class StripCompositor
+{
+public:
+    using Segment = SegmentStrip<BaseStrip>;
+
+    explicit StripCompositor(BaseStrip& base, double fps = 50)
+        : base_(base), fps_(fps) { }
+
+    ~StripCompositor() {
+        stop();
+    }
+
+    //! non-copyable: segments refer to the compositor
+    StripCompositor(const StripCompositor&) = delete;
+    StripCompositor& operator = (const StripCompositor&) = delete;
+
+    BaseStrip& base() { return base_; }
+
+    //! add a segment of size pixels after the previous ones
+    Segment& add_segment(size_t size) {
+        size_t offset = 0;
+        if (!segments_.empty())
+            offset = segments_.back()->offset() + segments_.back()->size();
+        segments_.emplace_back(new Segment(*this, offset, size));
+        return *segments_.back();
+    }
+
+    //! split the base strip into count segments of equal size, leaving a gap
+    //! of gap pixels between them.
+    void split(size_t count, size_t gap = 0) {
+        segments_.clear();
+        if (count == 0)
+            return;
+        size_t size = (base_.size() - (count - 1) * gap) / count;
+        for (size_t s = 0; s < count; ++s) {
+            segments_.emplace_back(
+                new Segment(*this, s * (size + gap), size));
+        }
+    }
+
+    //! number of segments
+    size_t segments() const { return segments_.size(); }
+
+    Segment& segment(size_t s) { return *segments_[s]; }
+
+    //! number of frames shown by the background thread
+    size_t frames() const { return frames_; }
+
+    //! copy the changed pixels of a segment to the base strip
+    void commit(Segment& s) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (size_t i = s.dirty_begin_; i < s.dirty_end_; ++i)
+            base_.setPixel(s.offset_ + i, s.pixels_[i]);
+        s.dirty_begin_ = s.pixels_.size(), s.dirty_end_ = 0;
+        ++commits_;
+
+        if (!running_ && !base_.busy())
+            base_.show();
+    }
+
+    //! start showing composed frames on a background thread
+    void start() {
+        if (running_)
+            return;
+        running_ = true;
+        stop_ = false;
+        thread_ = std::thread([this]() { show_loop(); });
+    }
+
+    //! stop the background thread after showing the last frame
+    void stop() {
+        if (!running_)
+            return;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        cv_.notify_all();
+        thread_.join();
+        running_ = false;
+    }
+
+    /*!
+     * Run func(segment, s) for each segment s on its own worker thread, while
+     * composing their frames, and return when all have finished. State of the
+     * animations like the array and the hook must be thread-local.
+     */
+    template <typename Function>
+    void run(Function func) {
+        start();
+        std::vector<std::thread> workers;
+        for (size_t s = 0; s < segments_.size(); ++s) {
+            workers.emplace_back(
+                [this, &func, s]() { func(*segments_[s], s); });
+        }
+        for (std::thread& t : workers)
+            t.join();
+        stop();
+    }
+
+private:
+    BaseStrip& base_;
+
+    //! maximum frame rate of the background thread
+    double fps_;
+
+    std::vector<std::unique_ptr<Segment> > segments_;
+
+    //! protects the base strip's pixels and the counters
+    std::mutex mutex_;
+    std::condition_variable cv_;
+
+    std::thread thread_;
+    bool running_ = false, stop_ = false;
+
+    //! number of commits, and number of commits at the last frame shown
+    size_t commits_ = 0, commits_shown_ = 0;
+
+    //! number of frames shown by the background thread
+    size_t frames_ = 0;
+
+    void show_loop() {
+        using Clock = std::chrono::steady_clock;
+        std::chrono::microseconds period(
+            static_cast<long>(1e6 / std::max(fps_, 1.0)));
+        Clock::time_point next = Clock::now();
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true) {
+            bool stopping = stop_;
+            // skip the frame if the base strip is still transmitting, except
+            // for the last one
+            if (commits_ != commits_shown_ && (stopping || !base_.busy())) {
+                commits_shown_ = commits_;
+                base_.show();
+                ++frames_;
+            }
+            if (stopping)
+                break;
+
+            next = std::max(next + period, Clock::now());
+            cv_.wait_until(lock, next, [this]() { return stop_; });
+        }
+    }
+};
+
+} // namespace BlinkenAlgorithms
+
+#endif // !BLINKENALGORITHMS_STRIP_SEGMENTSTRIP_HEADER
+
+/******************************************************************************/
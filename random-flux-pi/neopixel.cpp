@@ -24,6 +24,9 @@ void delay_poll() { }
 int main() {
     srandom(time(nullptr));
 
+    // transmit frames in the background while the next one is computed
+    strip.set_async(true);
+
     RunRandomFluxAnimations(strip);
 
     return 0;